@@ -0,0 +1,84 @@
+#include "advance.hpp"
+#ifdef __SSE2__
+    #include <immintrin.h>
+#endif
+
+void ProjectileBatch::resize(std::size_t count) {
+    size = count;
+    std::size_t padded = (count + ADVANCE_LANES - 1) / ADVANCE_LANES * ADVANCE_LANES;
+    if (padded > y.size()) // The arrays only grow, so that a batch reused every step doesn't touch them
+        for (std::vector<int16_t>* array : {&y, &x, &dy, &dx, &toY, &toX, &cell})
+            array->resize(padded);
+    for (std::size_t j=count; j<padded; j++) // The kernels run on whole vectors, the padding lanes stay in the field
+        y[j] = x[j] = dy[j] = dx[j] = 0;
+}
+
+void advanceScalar(ProjectileBatch& batch, int16_t height, int16_t width) {
+    for (std::size_t j=0; j<batch.size; j++) {
+        int16_t y = batch.y[j] + batch.dy[j];
+        int16_t x = batch.x[j] + batch.dx[j];
+        batch.toY[j] = y;
+        batch.toX[j] = x;
+        batch.cell[j] = y < 0 || y >= height || x < 0 || x >= width ? -1 : y * width + x;
+    }
+}
+
+#ifdef __SSE2__
+void advanceSse2(ProjectileBatch& batch, int16_t height, int16_t width) {
+    const __m128i heights = _mm_set1_epi16(height), widths = _mm_set1_epi16(width);
+    const __m128i zero = _mm_setzero_si128(), outside = _mm_set1_epi16(-1);
+    for (std::size_t j=0; j<batch.size; j+=8) {
+        __m128i y = _mm_add_epi16(_mm_loadu_si128((const __m128i*)&batch.y[j]), _mm_loadu_si128((const __m128i*)&batch.dy[j]));
+        __m128i x = _mm_add_epi16(_mm_loadu_si128((const __m128i*)&batch.x[j]), _mm_loadu_si128((const __m128i*)&batch.dx[j]));
+        _mm_storeu_si128((__m128i*)&batch.toY[j], y);
+        _mm_storeu_si128((__m128i*)&batch.toX[j], x);
+        __m128i inside = _mm_and_si128(
+            _mm_andnot_si128(_mm_or_si128(_mm_cmplt_epi16(y, zero), _mm_cmplt_epi16(x, zero)), _mm_cmplt_epi16(y, heights)),
+            _mm_cmplt_epi16(x, widths)
+        );
+        __m128i cell = _mm_add_epi16(_mm_mullo_epi16(y, widths), x);
+        cell = _mm_or_si128(_mm_and_si128(inside, cell), _mm_andnot_si128(inside, outside));
+        _mm_storeu_si128((__m128i*)&batch.cell[j], cell);
+    }
+}
+#endif
+
+#ifdef __AVX2__
+void advanceAvx2(ProjectileBatch& batch, int16_t height, int16_t width) {
+    const __m256i heights = _mm256_set1_epi16(height), widths = _mm256_set1_epi16(width);
+    const __m256i zero = _mm256_setzero_si256(), outside = _mm256_set1_epi16(-1);
+    for (std::size_t j=0; j<batch.size; j+=16) {
+        __m256i y = _mm256_add_epi16(_mm256_loadu_si256((const __m256i*)&batch.y[j]), _mm256_loadu_si256((const __m256i*)&batch.dy[j]));
+        __m256i x = _mm256_add_epi16(_mm256_loadu_si256((const __m256i*)&batch.x[j]), _mm256_loadu_si256((const __m256i*)&batch.dx[j]));
+        _mm256_storeu_si256((__m256i*)&batch.toY[j], y);
+        _mm256_storeu_si256((__m256i*)&batch.toX[j], x);
+        __m256i inside = _mm256_and_si256(
+            _mm256_andnot_si256(_mm256_or_si256(_mm256_cmpgt_epi16(zero, y), _mm256_cmpgt_epi16(zero, x)), _mm256_cmpgt_epi16(heights, y)),
+            _mm256_cmpgt_epi16(widths, x)
+        );
+        __m256i cell = _mm256_add_epi16(_mm256_mullo_epi16(y, widths), x);
+        cell = _mm256_or_si256(_mm256_and_si256(inside, cell), _mm256_andnot_si256(inside, outside));
+        _mm256_storeu_si256((__m256i*)&batch.cell[j], cell);
+    }
+}
+#endif
+
+const AdvanceKernel advanceKernels[] = {
+    advanceScalar,
+    #ifdef __SSE2__
+        advanceSse2,
+    #endif
+    #ifdef __AVX2__
+        advanceAvx2,
+    #endif
+};
+const char* const advanceKernelNames[] = {
+    "scalar",
+    #ifdef __SSE2__
+        "sse2",
+    #endif
+    #ifdef __AVX2__
+        "avx2",
+    #endif
+};
+const unsigned advanceKernelCount = sizeof(advanceKernels) / sizeof(advanceKernels[0]);
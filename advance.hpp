@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define ADVANCE_LANES 16 // Lanes of the widest kernel (int16 in AVX2), the arrays of a batch are padded to a multiple of it
+
+// The projectiles of a frame packed in arrays, one element per projectile, so that a kernel computes their next cells
+// for the whole batch at once. Only the projectiles benchmark runs the kernels: with a few dozen projectiles per frame,
+// packing them costs GameWorld::moveProjectiles as much as a kernel saves.
+struct ProjectileBatch {
+    std::size_t size = 0;
+    // Filled by the caller
+    std::vector<int16_t> y, x; // Cell of the projectile
+    std::vector<int16_t> dy, dx; // One-cell step in its direction
+    // Filled by the kernel
+    std::vector<int16_t> toY, toX; // Next cell, outside of the field if the projectile leaves it
+    std::vector<int16_t> cell; // toY*width + toX, -1 outside of the field
+
+    void resize(std::size_t); // Sets size, the arrays may be longer than it, the padding lanes are zeroed
+};
+
+// Fills the outputs of the batch for a height*width field
+typedef void (*AdvanceKernel)(ProjectileBatch&, int16_t height, int16_t width);
+
+void advanceScalar(ProjectileBatch&, int16_t, int16_t);
+#ifdef __SSE2__
+    void advanceSse2(ProjectileBatch&, int16_t, int16_t); // 8 lanes
+#endif
+#ifdef __AVX2__
+    void advanceAvx2(ProjectileBatch&, int16_t, int16_t); // 16 lanes
+#endif
+
+// The kernels of this build, from the narrowest, and their names
+extern const AdvanceKernel advanceKernels[];
+extern const char* const advanceKernelNames[];
+extern const unsigned advanceKernelCount;
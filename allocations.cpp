@@ -0,0 +1,19 @@
+// Every heap allocation of the process goes through this operator new, so that frames can be checked to be allocation-free.
+// Only the binaries that need the count (dodas, soak) link this file.
+#include "pool.hpp"
+#include <cstdlib>
+
+std::atomic<unsigned long long> heapAllocations(0);
+
+void* operator new(std::size_t size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size ? size : 1))
+        return pointer;
+    throw std::bad_alloc();
+}
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
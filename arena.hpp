@@ -0,0 +1,100 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+#define ARENA_SIZE 16384 // Initial bytes of a frame arena, enough for the temporaries of a crowded frame
+
+// Bump allocator for the temporaries of a frame: allocating moves an offset forward, nothing is freed until reset().
+// When the buffer is full the allocation falls back to the heap, and the next reset() grows the buffer to the peak,
+// so after the first crowded frames the arena doesn't touch the heap anymore.
+class FrameArena {
+public:
+    FrameArena() : buffer((unsigned char*)::operator new(ARENA_SIZE)), capacity(ARENA_SIZE) {}
+    ~FrameArena() {
+        release();
+        ::operator delete(buffer);
+    }
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(std::size_t size, std::size_t alignment) {
+        std::size_t start = (offset + alignment - 1) & ~(alignment - 1);
+        used += size + (start - offset);
+        if (start + size <= capacity) {
+            offset = start + size;
+            return buffer + start;
+        }
+        // Overflow: a heap block with a header chaining it to the other overflow blocks of the frame
+        std::size_t header = (sizeof(Overflow) + alignment - 1) & ~(alignment - 1);
+        Overflow* block = (Overflow*)::operator new(header + size);
+        block->next = overflow;
+        overflow = block;
+        return (unsigned char*)block + header;
+    }
+
+    // Releases everything allocated since the previous reset, recording how many bytes the frame used
+    void reset() {
+        lastFrameBytes = used;
+        if (used > peakBytes)
+            peakBytes = used;
+        if (overflow != nullptr) {
+            release();
+            ::operator delete(buffer);
+            capacity = peakBytes * 2; // Room for the alignment padding and for a slightly bigger frame
+            buffer = (unsigned char*)::operator new(capacity);
+        }
+        offset = 0;
+        used = 0;
+    }
+
+    std::size_t bytes() const { return used; } // Allocated since the last reset
+    std::size_t lastFrameBytes = 0; // Allocated during the frame before the last reset
+    std::size_t peakBytes = 0; // The most allocated by a single frame
+
+private:
+    struct Overflow {
+        Overflow* next;
+    };
+
+    void release() {
+        while (overflow != nullptr) {
+            Overflow* next = overflow->next;
+            ::operator delete(overflow);
+            overflow = next;
+        }
+    }
+
+    unsigned char* buffer;
+    std::size_t capacity;
+    std::size_t offset = 0;
+    std::size_t used = 0;
+    Overflow* overflow = nullptr;
+};
+
+// Allocator for standard containers living only until the end of the frame, deallocation does nothing
+template <typename T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+
+    ArenaAllocator(FrameArena& arena) : arena(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(std::size_t count) {
+        return (T*)arena->allocate(count * sizeof(T), alignof(T));
+    }
+    void deallocate(T*, std::size_t) {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+
+    FrameArena* arena;
+};
+
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
@@ -0,0 +1,204 @@
+// Monte Carlo balancing runner: plays many headless games per parameter set, one thread per core, and prints a results table
+//
+//  ./balance [-g games] [-j jobs] [-f maxFrames] [-s seed] [-p policy] [-c scenario] [parameters file]
+//
+// Every non-empty line of the parameters file that doesn't start with '#' is a parameter set:
+//  name key=value key=value ...
+// with keys cannon_period, worker_period, zombie_move, zombie_shoot, walker_move, start_ammo, projectile_speed,
+// walker_paths (0 or 1) and hardcore (0 or 1).
+// Without a file a single "default" set, using the constants of dodas.hpp, is played.
+// Every game starts from the built-in layout, or from the scenario file given with -c (scenario.hpp).
+#include "bot.hpp"
+#include "scenario.hpp"
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#define BALANCE_GAMES 1000 // Games played per parameter set
+#define BALANCE_MAX_FRAMES 20000 // Games still running after this many frames count as timeouts
+
+struct ParameterSet {
+    std::string name;
+    Balance balance;
+    bool hardcore = false;
+};
+
+enum Outcome : uint8_t {WON, LOST, TIMEOUT};
+
+struct GameResult {
+    uint32_t set;
+    uint32_t frames;
+    Outcome outcome;
+};
+
+static bool parseParameterSet(const std::string& line, ParameterSet& set) {
+    std::istringstream stream(line);
+    if (!(stream >> set.name))
+        return false;
+    std::string pair;
+    while (stream >> pair) {
+        std::size_t equal = pair.find('=');
+        if (equal == std::string::npos)
+            return false;
+        std::string key = pair.substr(0, equal);
+        double value = std::atof(pair.c_str() + equal + 1);
+        if (key == "cannon_period" && value >= 1) {
+            set.balance.cannonFirePeriod = value;
+        } else if (key == "worker_period" && value >= 1) {
+            set.balance.workerProductionPeriod = value;
+        } else if (key == "zombie_move" && value >= 0 && value <= 1) {
+            set.balance.zombieMovingProbability = value;
+        } else if (key == "zombie_shoot" && value >= 0 && value <= 1) {
+            set.balance.zombieShootingProbability = value;
+        } else if (key == "walker_move" && value >= 0 && value <= 1) {
+            set.balance.walkerMovingProbability = value;
+        } else if (key == "projectile_speed" && value >= 1) {
+            set.balance.projectileSpeed = value;
+        } else if (key == "start_ammo") {
+            set.balance.startAmmonition = value;
+        } else if (key == "walker_paths") {
+            set.balance.walkerPathfinding = value != 0;
+        } else if (key == "hardcore") {
+            set.hardcore = value != 0;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+static GameResult playGame(uint32_t set, const ParameterSet& parameters, const Scenario& scenario, const std::string& policyName, unsigned seed, unsigned maxFrames) {
+    GameWorld world(seed);
+    world.balance = parameters.balance;
+    world.applyBalance();
+    world.scenario = scenario;
+    std::unique_ptr<Policy> policy = makePolicy(policyName, seed ^ 0x9E3779B9);
+    world.populate();
+    unsigned i = 0;
+    while (!world.end && i < maxFrames) {
+        applyAction(world, policy->decide(world));
+        world.update(i++, parameters.hardcore);
+    }
+    GameResult result;
+    result.set = set;
+    result.frames = i;
+    if (world.queen->life <= 0) {
+        result.outcome = Outcome::WON;
+    } else if (world.end) {
+        result.outcome = Outcome::LOST;
+    } else {
+        result.outcome = Outcome::TIMEOUT;
+    }
+    return result;
+}
+
+int main(int argc, char** argv) {
+    unsigned games = BALANCE_GAMES;
+    unsigned jobs = std::max(1u, std::thread::hardware_concurrency());
+    unsigned maxFrames = BALANCE_MAX_FRAMES;
+    unsigned baseSeed = 1;
+    std::string policyName = "random";
+    std::vector<ParameterSet> sets;
+    Scenario scenario = defaultScenario();
+    for (int i=1; i<argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-g" && i + 1 < argc) {
+            games = std::atoi(argv[++i]);
+        } else if (arg == "-j" && i + 1 < argc) {
+            jobs = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "-f" && i + 1 < argc) {
+            maxFrames = std::atoi(argv[++i]);
+        } else if (arg == "-s" && i + 1 < argc) {
+            baseSeed = std::atoi(argv[++i]);
+        } else if (arg == "-p" && i + 1 < argc) {
+            policyName = argv[++i];
+            if (makePolicy(policyName, 0) == nullptr) {
+                std::cerr << "Unknown policy " << policyName << std::endl;
+                return 1;
+            }
+        } else if (arg == "-c" && i + 1 < argc) {
+            std::string error;
+            if (!loadScenario(scenario, argv[++i], error)) {
+                std::cerr << "Invalid scenario, " << error << std::endl;
+                return 1;
+            }
+        } else {
+            std::ifstream file(arg);
+            if (!file) {
+                std::cerr << "Could not open " << arg << std::endl;
+                return 1;
+            }
+            std::string line;
+            while (std::getline(file, line)) {
+                if (line.empty() || line[0] == '#') continue;
+                ParameterSet set;
+                if (!parseParameterSet(line, set)) {
+                    std::cerr << "Invalid parameter set: " << line << std::endl;
+                    return 1;
+                }
+                sets.push_back(set);
+            }
+        }
+    }
+    if (sets.empty()) {
+        sets.push_back(ParameterSet{"default"});
+    }
+    unsigned total = sets.size() * games;
+
+    // Each thread owns the world it is playing, and pulls game indices from a shared counter so that long games don't leave cores idle
+    NullBuffer nullBuffer; // Sista prints every change of the fields on std::cout, the headless worlds discard it
+    std::streambuf* stdoutBuffer = std::cout.rdbuf(&nullBuffer);
+    std::atomic<unsigned> next(0);
+    std::vector<std::vector<GameResult>> results(jobs);
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned job=0; job<jobs; job++) {
+        threads.emplace_back([&, job]() {
+            for (unsigned game = next++; game < total; game = next++)
+                results[job].push_back(playGame(game / games, sets[game / games], scenario, policyName, baseSeed + game, maxFrames));
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+    std::cout.rdbuf(stdoutBuffer);
+
+    std::vector<unsigned> wins(sets.size()), losses(sets.size()), timeouts(sets.size());
+    std::vector<unsigned long long> framesToWin(sets.size()), survival(sets.size());
+    unsigned received = 0;
+    for (const std::vector<GameResult>& jobResults : results) {
+        for (const GameResult& result : jobResults) {
+            received++;
+            if (result.outcome == Outcome::WON) {
+                wins[result.set]++;
+                framesToWin[result.set] += result.frames;
+            } else if (result.outcome == Outcome::LOST) {
+                losses[result.set]++;
+                survival[result.set] += result.frames;
+            } else {
+                timeouts[result.set]++;
+            }
+        }
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << std::left << std::setw(20) << "set" << std::right;
+    std::cout << std::setw(8) << "games" << std::setw(8) << "win%" << std::setw(14) << "frames-to-win";
+    std::cout << std::setw(8) << "lost" << std::setw(10) << "survival" << std::setw(10) << "timeouts" << '\n';
+    std::cout << std::fixed << std::setprecision(1);
+    for (unsigned j=0; j<sets.size(); j++) {
+        unsigned played = wins[j] + losses[j] + timeouts[j];
+        std::cout << std::left << std::setw(20) << sets[j].name << std::right;
+        std::cout << std::setw(8) << played;
+        std::cout << std::setw(8) << (played ? 100.0 * wins[j] / played : 0.0);
+        std::cout << std::setw(14) << (wins[j] ? (double)framesToWin[j] / wins[j] : 0.0);
+        std::cout << std::setw(8) << losses[j];
+        std::cout << std::setw(10) << (losses[j] ? (double)survival[j] / losses[j] : 0.0);
+        std::cout << std::setw(10) << timeouts[j] << '\n';
+    }
+    std::cerr << received << "/" << total << " games in " << elapsed << "s on " << jobs << " threads" << std::endl;
+    return received == total ? 0 : 1;
+}
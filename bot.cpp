@@ -0,0 +1,147 @@
+#include "bot.hpp"
+
+void applyAction(GameWorld& world, const BotAction& action) {
+    switch (action.kind) {
+    case BotAction::Kind::MOVE:
+        world.player->move(action.direction);
+        break;
+    case BotAction::Kind::SHOOT:
+        world.player->shoot(action.direction);
+        break;
+    case BotAction::Kind::SELECT:
+        world.player->weapon = action.weapon;
+        break;
+    case BotAction::Kind::WAIT:
+        break;
+    }
+}
+
+static BotAction move(Direction direction) {
+    BotAction action;
+    action.kind = BotAction::Kind::MOVE;
+    action.direction = direction;
+    return action;
+}
+static BotAction shoot(Direction direction) {
+    BotAction action;
+    action.kind = BotAction::Kind::SHOOT;
+    action.direction = direction;
+    return action;
+}
+static BotAction select(Type weapon) {
+    BotAction action;
+    action.kind = BotAction::Kind::SELECT;
+    action.weapon = weapon;
+    return action;
+}
+
+RandomPolicy::RandomPolicy(unsigned seed) : rng(seed) {}
+BotAction RandomPolicy::decide(const GameWorld&) {
+    static const Type weapons[] = {Type::BULLET, Type::MINE, Type::CANNON, Type::BOMBER, Type::WORKER, Type::ARMED_WORKER, Type::WALL};
+    unsigned action = rng() % 16;
+    if (action < 4) {
+        return move((Direction)action);
+    } else if (action < 8) {
+        return shoot((Direction)(action - 4));
+    } else if (action == 8) {
+        return select(weapons[rng() % 7]);
+    }
+    return BotAction(); // Otherwise the player waits
+}
+
+static bool isFree(const GameWorld& world, sista::Coordinates coordinates) {
+    return !world.field->isOutOfBounds(coordinates) && world.field->isFree(coordinates);
+}
+
+// Whether a bullet shot right from column x of row y would hit a zombie, instead of wasting itself on a wall
+static bool enemyInSight(const GameWorld& world, unsigned short y, unsigned short x) {
+    for (x++; x<WIDTH; x++) {
+        Entity* entity = (Entity*)world.field->getPawn(y, x);
+        if (entity != nullptr)
+            return typeTraits[entity->type].collision == HORDE;
+    }
+    return false;
+}
+
+// Whether an enemy bullet, or a walker first in line on the right, is less than BOT_DANGER_DISTANCE frames away
+static bool inDanger(const GameWorld& world, sista::Coordinates position, bool walkers) {
+    if (world.lanes.framesToImpact(position, Type::ENEMYBULLET) <= BOT_DANGER_DISTANCE)
+        return true;
+    if (!walkers)
+        return false;
+    for (unsigned short x=position.x+1; x<WIDTH && x<=position.x+BOT_DANGER_DISTANCE; x++) {
+        Entity* entity = (Entity*)world.field->getPawn(position.y, x);
+        if (entity != nullptr)
+            return entity->type == Type::WALKER;
+    }
+    return false;
+}
+
+// Moves vertically towards the nearest row whose cell at column x is free, waits if there is none
+static BotAction moveTowardsFreeRow(const GameWorld& world, sista::Coordinates position, unsigned short x) {
+    for (unsigned short distance=1; distance<HEIGHT; distance++) {
+        if (position.y >= distance && isFree(world, {(unsigned short)(position.y - distance), x}))
+            return move(Direction::UP);
+        if (position.y + distance < HEIGHT && isFree(world, {(unsigned short)(position.y + distance), x}))
+            return move(Direction::DOWN);
+    }
+    return BotAction();
+}
+
+BotAction HeuristicPolicy::decide(const GameWorld& world) {
+    Player& player = *world.player;
+    sista::Coordinates position = player.getCoordinates();
+    if (position.x != BOT_COLUMN) { // Go back to the column, walking around what is in the way
+        Direction direction = position.x < BOT_COLUMN ? Direction::RIGHT : Direction::LEFT;
+        if (isFree(world, position + directionOffset(direction)))
+            return move(direction);
+        return isFree(world, position + directionOffset(Direction::DOWN)) ? move(Direction::DOWN) : move(Direction::UP);
+    }
+    sista::Coordinates right = position + directionOffset(Direction::RIGHT);
+    sista::Coordinates left = position + directionOffset(Direction::LEFT);
+
+    // Enemy bullets are dodged, walkers are shot and dodged only without ammonitions
+    bool armed = player.ammonitions >= 1 && isFree(world, right);
+    if (inDanger(world, position, !armed)) {
+        sista::Coordinates up = position + directionOffset(Direction::UP);
+        sista::Coordinates down = position + directionOffset(Direction::DOWN);
+        if (isFree(world, up) && !inDanger(world, up, true))
+            return move(Direction::UP);
+        if (isFree(world, down) && !inDanger(world, down, true))
+            return move(Direction::DOWN);
+    }
+
+    if (armed && enemyInSight(world, position.y, position.x)) {
+        if (player.weapon != Type::BULLET)
+            return select(Type::BULLET);
+        return shoot(Direction::RIGHT);
+    }
+
+    if (player.ammonitions >= std::max(typeTraits[Type::WORKER].cost, typeTraits[Type::CANNON].cost) + BOT_RESERVE) {
+        bool buildWorker = world.workers.size() < BOT_WORKERS_PER_CANNON * (world.cannons.size() + 2);
+        Type weapon = buildWorker ? Type::WORKER : Type::CANNON;
+        sista::Coordinates target = buildWorker ? left : right;
+        if (!isFree(world, target))
+            return moveTowardsFreeRow(world, position, target.x);
+        if (player.weapon != weapon)
+            return select(weapon);
+        return shoot(buildWorker ? Direction::LEFT : Direction::RIGHT);
+    }
+
+    // Saving ammonitions: wait in the nearest row with an enemy in sight
+    for (unsigned short distance=1; distance<HEIGHT; distance++) {
+        if (position.y >= distance && isFree(world, {(unsigned short)(position.y - distance), right.x}) && enemyInSight(world, position.y - distance, position.x))
+            return move(Direction::UP);
+        if (position.y + distance < HEIGHT && isFree(world, {(unsigned short)(position.y + distance), right.x}) && enemyInSight(world, position.y + distance, position.x))
+            return move(Direction::DOWN);
+    }
+    return BotAction();
+}
+
+std::unique_ptr<Policy> makePolicy(const std::string& name, unsigned seed) {
+    if (name == "random")
+        return std::make_unique<RandomPolicy>(seed);
+    if (name == "heuristic")
+        return std::make_unique<HeuristicPolicy>();
+    return nullptr;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "dodas.hpp"
+#include <memory>
+#include <string>
+
+#define BOT_COLUMN 27 // The heuristic player walks up and down this column, building cannons on its right and workers on its left
+#define BOT_DANGER_DISTANCE 4 // The heuristic player steps aside from enemy bullets and walkers less than this many frames away
+#define BOT_WORKERS_PER_CANNON 3 // The heuristic player builds a cannon only when it has this many workers per cannon, plus one cannon's worth
+#define BOT_RESERVE 3 // Ammonitions the heuristic player keeps for shooting instead of building
+
+// One of the commands the input thread can give to the player
+struct BotAction {
+    enum Kind : uint8_t {WAIT, MOVE, SHOOT, SELECT};
+    Kind kind = Kind::WAIT;
+    Direction direction = Direction::UP; // For MOVE and SHOOT
+    Type weapon = Type::BULLET; // For SELECT
+};
+
+// Performs the action exactly as the corresponding key would (Player::move, Player::shoot, weapon selection)
+void applyAction(GameWorld&, const BotAction&);
+
+// Decides the next action of the player from the state of the world, called once per frame
+class Policy {
+public:
+    virtual ~Policy() = default;
+    virtual BotAction decide(const GameWorld&) = 0;
+};
+
+class RandomPolicy : public Policy { // Moves, shoots and selects weapons at random, waiting half of the time
+public:
+    RandomPolicy(unsigned);
+    BotAction decide(const GameWorld&) override;
+
+private:
+    std::mt19937 rng;
+};
+
+class HeuristicPolicy : public Policy { // Fires at the zombies in its row, otherwise builds workers and cannons behind the macrowall
+public:
+    BotAction decide(const GameWorld&) override;
+};
+
+// Returns the policy called name ("random" or "heuristic"), nullptr if there is none
+std::unique_ptr<Policy> makePolicy(const std::string& name, unsigned seed);
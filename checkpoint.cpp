@@ -0,0 +1,73 @@
+#include "checkpoint.hpp"
+#include <algorithm>
+#include <cstdio>
+
+Checkpointer::Checkpointer() : copy(0) {}
+Checkpointer::~Checkpointer() {
+    stop();
+}
+
+void Checkpointer::start(const std::string& path) {
+    this->path = path;
+    stopping = false;
+    thread = std::thread(&Checkpointer::run, this);
+}
+
+void Checkpointer::stop() {
+    if (!thread.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeUp.notify_one();
+    thread.join();
+}
+
+bool Checkpointer::take(const GameWorld& world, const SnapshotInfo& snapshotInfo) {
+    if (!thread.joinable() || writing.load(std::memory_order_acquire)) {
+        skipped++;
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+    world.fork(copy);
+    info = snapshotInfo;
+    writing.store(true, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending = true;
+    }
+    wakeUp.notify_one();
+    lastStall = std::chrono::steady_clock::now() - start;
+    maxStall = std::max(maxStall, lastStall);
+    taken++;
+    return true;
+}
+
+void Checkpointer::run() {
+    std::string temporary = path + ".tmp";
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeUp.wait(lock, [this]() { return pending || stopping; });
+            if (!pending)
+                return; // Stopping, and the last checkpoint is written
+            pending = false;
+        }
+        traceFrame = info.frame;
+        if (saveSnapshot(copy, temporary, info)) {
+            #ifdef _WIN32
+                std::remove(path.c_str()); // rename doesn't replace an existing file on Windows
+            #endif
+            if (std::rename(temporary.c_str(), path.c_str()) == 0) {
+                lastBytes.store(info.bytes, std::memory_order_relaxed);
+                lastWriteMicroseconds.store(info.elapsed.count(), std::memory_order_relaxed);
+            } else {
+                failed++;
+            }
+        } else {
+            failed++;
+        }
+        writing.store(false, std::memory_order_release);
+    }
+}
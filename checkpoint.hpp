@@ -0,0 +1,51 @@
+#pragma once
+#include "dodas.hpp"
+#include "snapshot.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#define CHECKPOINT_FILE "dodas.ckpt" // Newest checkpoint, a snapshot resumed by --resume
+#define CHECKPOINT_PERIOD 600 // Default frames between two checkpoints of hardcore and endless sessions, a minute at 10 frames per second
+
+// Periodic checkpoints of a running game that don't stall the frame loop: the frame loop only forks the world into a
+// copy (GameWorld::fork, a few microseconds), a background thread writes the copy as a snapshot to a temporary file
+// and renames it over the checkpoint, so a crash at any moment leaves the previous checkpoint whole.
+// If the previous checkpoint is still being written when the next one is due, the next one is skipped.
+class Checkpointer {
+public:
+    // Time the frame loop spent in take(), the only cost of a checkpoint to the game
+    std::chrono::nanoseconds lastStall{0};
+    std::chrono::nanoseconds maxStall{0};
+    unsigned long long taken = 0;
+    unsigned long long skipped = 0;
+    // Written by the background thread, for the last checkpoint on disk
+    std::atomic<std::size_t> lastBytes{0};
+    std::atomic<long long> lastWriteMicroseconds{0};
+    std::atomic<unsigned long long> failed{0};
+
+    Checkpointer();
+    ~Checkpointer();
+
+    void start(const std::string& path); // Starts the background thread, checkpoints are written to path
+    void stop(); // Waits for the checkpoint being written, if any, and joins the thread
+    // Called by the frame loop at the end of a frame, with the world locked. info holds the frame the game would
+    // resume from and the mode. Returns false if the checkpoint was skipped.
+    bool take(const GameWorld&, const SnapshotInfo& info);
+
+private:
+    GameWorld copy; // The world of the checkpoint being written, only touched by take() while no write is pending
+    SnapshotInfo info;
+    std::string path;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    bool pending = false; // A checkpoint was taken and isn't written yet, guarded by mutex
+    bool stopping = false; // Guarded by mutex
+    std::atomic<bool> writing{false}; // From take() until the file is renamed
+
+    void run();
+};
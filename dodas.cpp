@@ -1,38 +1,21 @@
 #include "cross_platform.hpp"
 #include "dodas.hpp"
+#include "snapshot.hpp"
+#include "checkpoint.hpp"
+#include "rewind.hpp"
+#include "bot.hpp"
+#include "metrics.hpp"
+#include "scenario.hpp"
 #include <algorithm>
+#include <cstdlib>
 #include <fstream>
 #include <thread>
 #include <chrono>
 #include <mutex>
 #include <iostream>
 
-#if DEBUG
-std::ofstream debug("debug.log");
-#endif
-
-sista::SwappableField* field;
-
-std::vector<std::shared_ptr<Bullet>> Bullet::bullets;
-std::vector<std::shared_ptr<EnemyBullet>> EnemyBullet::enemyBullets;
-std::vector<std::shared_ptr<Zombie>> Zombie::zombies;
-std::vector<std::shared_ptr<Walker>> Walker::walkers;
-std::vector<std::shared_ptr<Wall>> Wall::walls;
-std::vector<std::shared_ptr<Mine>> Mine::mines;
-std::vector<std::shared_ptr<Cannon>> Cannon::cannons;
-std::vector<std::shared_ptr<ArmedWorker>> ArmedWorker::armedWorkers;
-std::vector<std::shared_ptr<Worker>> Worker::workers;
-std::vector<std::shared_ptr<Bomber>> Bomber::bombers;
-std::shared_ptr<Player> Player::player;
-std::shared_ptr<Queen> Queen::queen;
-
-std::bernoulli_distribution Zombie::distribution(ZOMBIE_MOVING_PROBABILITY);
-std::bernoulli_distribution Zombie::shootDistribution(ZOMBIE_SHOOTING_PROBABILITY);
-std::bernoulli_distribution Walker::distribution(WALKER_MOVING_PROBABILITY);
 sista::Cursor cursor;
-std::mutex inputOutputMutex;
-bool pause_ = false;
-bool end = false;
+bool saveRequested = false; // Set by the input thread, the snapshot is written by the frame loop at the end of the frame
 
 int main(int argc, char** argv) {
     #ifdef __APPLE__
@@ -44,9 +27,10 @@ int main(int argc, char** argv) {
     #if INTRO
         printIntro();
     #endif
-    sista::SwappableField field_(50, 20);
-    field = &field_;
-    field->clear();
+    GameWorld world;
+    JobSystem jobs; // Up to one thread per core, only started once a phase of a frame has more than one job
+    world.jobs = &jobs;
+    world.field->clear();
     sista::Border border(
         '#', {
             sista::ForegroundColor::WHITE,
@@ -54,12 +38,21 @@ int main(int argc, char** argv) {
             sista::Attribute::BRIGHT
         }
     );
-    std::default_random_engine rng(std::chrono::system_clock::now().time_since_epoch().count());
     // Default settings
     bool unofficial = false;
     bool music = true;
     bool endless = false;
     bool hardcore = false;
+    std::string loadPath; // Empty unless a snapshot has to be resumed
+    int checkpointPeriod = -1; // Frames between two checkpoints, 0 for none, -1 for CHECKPOINT_PERIOD in hardcore and endless mode only
+    std::string scenarioPath; // Empty for the built-in layout and waves
+    std::unique_ptr<Policy> bot; // Plays instead of the keyboard when set
+    std::string metricsPath; // Empty unless the metrics are served
+    #if DEBUG
+    TraceLevel traceLevel = TRACE_DEBUG;
+    #else
+    TraceLevel traceLevel = TRACE_OFF;
+    #endif
     if (argc > 1) {
         for (unsigned short i=1; i<argc; i++) {
             // if argv contains "--unofficial" or "-u" then the game will be played in the unofficial mode
@@ -85,37 +78,103 @@ int main(int argc, char** argv) {
             if (std::string(argv[i]) == "--hardcore" || std::string(argv[i]) == "-h" || std::string(argv[i]) == "-H") {
                 hardcore = true;
             }
+            // if argv contains "--load" or "-L" then the game is resumed from a snapshot (the next argument, if any, is its path)
+            if (std::string(argv[i]) == "--load" || std::string(argv[i]) == "-l" || std::string(argv[i]) == "-L") {
+                loadPath = SNAPSHOT_FILE;
+                if (i + 1 < argc && argv[i+1][0] != '-')
+                    loadPath = argv[++i];
+            }
+            // if argv contains "--resume" or "-R" then the game is resumed from the newest checkpoint
+            if (std::string(argv[i]) == "--resume" || std::string(argv[i]) == "-r" || std::string(argv[i]) == "-R") {
+                loadPath = CHECKPOINT_FILE;
+            }
+            // if argv contains "--checkpoint" or "-K" then checkpoints are taken in any mode (the next argument, if any, is the number of frames between two, 0 disables them)
+            if (std::string(argv[i]) == "--checkpoint" || std::string(argv[i]) == "-k" || std::string(argv[i]) == "-K") {
+                checkpointPeriod = CHECKPOINT_PERIOD;
+                if (i + 1 < argc && argv[i+1][0] >= '0' && argv[i+1][0] <= '9')
+                    checkpointPeriod = std::atoi(argv[++i]);
+            }
+            // if argv contains "--scenario" or "-C" then the layout and the waves are read from the file in the next argument
+            if ((std::string(argv[i]) == "--scenario" || std::string(argv[i]) == "-c" || std::string(argv[i]) == "-C") && i + 1 < argc) {
+                scenarioPath = argv[++i];
+            }
+            // if argv contains "--bot" or "-B" then a bot plays (the next argument, if any, is its policy, "heuristic" by default)
+            if (std::string(argv[i]) == "--bot" || std::string(argv[i]) == "-b" || std::string(argv[i]) == "-B") {
+                std::string policy = "heuristic";
+                if (i + 1 < argc && argv[i+1][0] != '-')
+                    policy = argv[++i];
+                bot = makePolicy(policy, time(0));
+                if (bot == nullptr) {
+                    std::cerr << "Unknown bot policy " << policy << std::endl;
+                    return 1;
+                }
+                border = sista::Border('0', {
+                        sista::ForegroundColor::WHITE,
+                        sista::BackgroundColor::BLACK,
+                        sista::Attribute::BRIGHT
+                    }
+                );
+                unofficial = true; // A bot run can't be a record
+            }
+            // if argv contains "--metrics" or "-S" then the statistics are served on a Unix socket (the next argument, if any, is its path)
+            if (std::string(argv[i]) == "--metrics" || std::string(argv[i]) == "-s" || std::string(argv[i]) == "-S") {
+                metricsPath = defaultMetricsPath();
+                if (i + 1 < argc && argv[i+1][0] != '-')
+                    metricsPath = argv[++i];
+            }
+            // if argv contains "--trace" or "-T" then the events are traced to TRACE_FILE (the next argument, if any, is the level, "info" by default)
+            if (std::string(argv[i]) == "--trace" || std::string(argv[i]) == "-t" || std::string(argv[i]) == "-T") {
+                traceLevel = TRACE_INFO;
+                if (i + 1 < argc && argv[i+1][0] != '-' && !parseTraceLevel(argv[++i], traceLevel)) {
+                    std::cerr << "Unknown trace level " << argv[i] << ", expected error, info or debug" << std::endl;
+                    return 1;
+                }
+            }
         }
     }
 
-    Player::player = std::make_shared<Player>(sista::Coordinates{10, 18});
-    field->addPawn(Player::player);
-    Queen::queen = std::make_shared<Queen>(sista::Coordinates{10, 49});
-    field->addPawn(Queen::queen);
-    for (unsigned short j=0; j<20; j++) {
-        std::shared_ptr<Wall> wall = std::make_shared<Wall>(sista::Coordinates{j, 30}, 3); // There is a vertical macrowall in the middle of the field
-        Wall::walls.push_back(wall);
-        field->addPawn(wall);
-        if (j % 5 == 1) {
-            // Zombies are spawned on the right side of the field (the mother side)
-            std::shared_ptr<Zombie> zombie = std::make_shared<Zombie>(sista::Coordinates{j, 47});
-            Zombie::zombies.push_back(zombie);
-            field->addPawn(zombie);
-        }
-        if (j % 5 == 3) {
-            // Walkers are spawned on the right side of the field (the mother side)
-            std::shared_ptr<Walker> walker = std::make_shared<Walker>(sista::Coordinates{j, 45});
-            Walker::walkers.push_back(walker);
-            field->addPawn(walker);
-        }
-        if (j % 5 == 2) {
-            // Workers are spawned on the left side of the field (the player side)
-            std::shared_ptr<Worker> worker = std::make_shared<Worker>(sista::Coordinates{j, 1});
-            Worker::workers.push_back(worker);
-            field->addPawn(worker);
+    if (traceLevel != TRACE_OFF && !tracer.start(TRACE_FILE, traceLevel))
+        std::cerr << "Could not create the trace " << TRACE_FILE << std::endl;
+    if (!scenarioPath.empty()) {
+        std::string error;
+        if (!loadScenario(world.scenario, scenarioPath, error)) {
+            std::cerr << "Invalid scenario, " << error << std::endl;
+            return 1;
         }
+        unofficial = true; // Records are only comparable on the built-in layout
+        border = sista::Border('0', {
+                sista::ForegroundColor::WHITE,
+                sista::BackgroundColor::BLACK,
+                sista::Attribute::BRIGHT
+            }
+        );
     }
-    field->print(border);
+    unsigned startFrame = 0;
+    SnapshotInfo snapshotInfo;
+    if (!loadPath.empty()) {
+        if (!loadSnapshot(world, loadPath, snapshotInfo)) {
+            std::cerr << "Could not load the snapshot " << loadPath << std::endl;
+            return 1;
+        }
+        startFrame = snapshotInfo.frame;
+        hardcore = snapshotInfo.hardcore;
+        endless = snapshotInfo.endless;
+        unofficial = true; // A resumed run can't be a record
+        border = sista::Border('0', {
+                sista::ForegroundColor::WHITE,
+                sista::BackgroundColor::BLACK,
+                sista::Attribute::BRIGHT
+            }
+        );
+    } else {
+        world.populate();
+    }
+    if (checkpointPeriod < 0)
+        checkpointPeriod = hardcore || endless ? CHECKPOINT_PERIOD : 0; // The long sessions, where a crash loses the most
+    Checkpointer checkpointer;
+    if (checkpointPeriod > 0)
+        checkpointer.start(CHECKPOINT_FILE);
+    world.field->print(border);
     #if TUTORIAL
         tutorial();
     #endif
@@ -123,93 +182,99 @@ int main(int argc, char** argv) {
     std::thread th = std::thread([&]() {
         char input = '_';
         while (input != 'Q' /*&& input != 'q'*/) {
-            if (end) return;
+            if (world.end) return;
             #if defined(_WIN32) or defined(__linux__)
                 input = getch();
             #elif __APPLE__
                 input = getchar();
             #endif
-            if (end) return;
+            if (world.end) return;
             switch (input) {
             case 'w': {
-                std::lock_guard<std::mutex> lock(inputOutputMutex);
-                Player::player->move(Direction::UP);
+                std::lock_guard<std::mutex> lock(world.mutex);
+                world.player->move(Direction::UP);
                 break;
             }
             case 'd': case 'D': {
-                std::lock_guard<std::mutex> lock(inputOutputMutex);
-                Player::player->move(Direction::RIGHT);
+                std::lock_guard<std::mutex> lock(world.mutex);
+                world.player->move(Direction::RIGHT);
                 break;
             }
             case 's': case 'S': {
-                std::lock_guard<std::mutex> lock(inputOutputMutex);
-                Player::player->move(Direction::DOWN);
+                std::lock_guard<std::mutex> lock(world.mutex);
+                world.player->move(Direction::DOWN);
                 break;
             }
             case 'a': case 'A': {
-                std::lock_guard<std::mutex> lock(inputOutputMutex);
-                Player::player->move(Direction::LEFT);
+                std::lock_guard<std::mutex> lock(world.mutex);
+                world.player->move(Direction::LEFT);
                 break;
             }
             case 'j': case 'J': {
-                std::lock_guard<std::mutex> lock(inputOutputMutex);
-                Player::player->shoot(Direction::LEFT);
+                std::lock_guard<std::mutex> lock(world.mutex);
+                world.player->shoot(Direction::LEFT);
                 break;
             }
             case 'k': case 'K': {
-                std::lock_guard<std::mutex> lock(inputOutputMutex);
-                Player::player->shoot(Direction::DOWN);
+                std::lock_guard<std::mutex> lock(world.mutex);
+                world.player->shoot(Direction::DOWN);
                 break;
             }
             case 'l': case 'L': {
-                Player::player->shoot(Direction::RIGHT);
+                std::lock_guard<std::mutex> lock(world.mutex);
+                world.player->shoot(Direction::RIGHT);
                 break;
             }
             case 'i': case 'I': {
-                std::lock_guard<std::mutex> lock(inputOutputMutex);
-                Player::player->shoot(Direction::UP);
+                std::lock_guard<std::mutex> lock(world.mutex);
+                world.player->shoot(Direction::UP);
                 break;
             }
             case 'b': case 'B': {
-                std::lock_guard<std::mutex> lock(inputOutputMutex);
-                Player::player->weapon = Type::BULLET;
+                std::lock_guard<std::mutex> lock(world.mutex);
+                world.player->weapon = Type::BULLET;
                 break;
             }
             case 'm': case 'M': {
-                std::lock_guard<std::mutex> lock(inputOutputMutex);
-                Player::player->weapon = Type::MINE;
+                std::lock_guard<std::mutex> lock(world.mutex);
+                world.player->weapon = Type::MINE;
                 break;
             }
             case 'c': case 'C': {
-                std::lock_guard<std::mutex> lock(inputOutputMutex);
-                Player::player->weapon = Type::CANNON;
+                std::lock_guard<std::mutex> lock(world.mutex);
+                world.player->weapon = Type::CANNON;
                 break;
             }
             case 'e': case 'E': { // E for explosive
-                std::lock_guard<std::mutex> lock(inputOutputMutex);
-                Player::player->weapon = Type::BOMBER;
+                std::lock_guard<std::mutex> lock(world.mutex);
+                world.player->weapon = Type::BOMBER;
                 break;
             }
             case 'W': case 'g': case 'G': { // W for worker, g for gatherer
-                std::lock_guard<std::mutex> lock(inputOutputMutex);
-                Player::player->weapon = Type::WORKER;
+                std::lock_guard<std::mutex> lock(world.mutex);
+                world.player->weapon = Type::WORKER;
                 break;
             }
             case 'u': case 'U' : {
-                std::lock_guard<std::mutex> lock(inputOutputMutex);
-                Player::player->weapon = Type::ARMED_WORKER;
+                std::lock_guard<std::mutex> lock(world.mutex);
+                world.player->weapon = Type::ARMED_WORKER;
                 break;
             }
             case '=': case '0': case '#': {
-                std::lock_guard<std::mutex> lock(inputOutputMutex);
-                Player::player->weapon = Type::WALL;
+                std::lock_guard<std::mutex> lock(world.mutex);
+                world.player->weapon = Type::WALL;
+                break;
+            }
+            case 'v': case 'V': { // Save a snapshot of the game
+                std::lock_guard<std::mutex> lock(world.mutex);
+                saveRequested = true;
                 break;
             }
             case '.': case 'p': case 'P': // Pause
-                pause_ = !pause_;
+                world.paused = !world.paused;
                 break;
             case 'Q': /* case 'q': */
-                end = true;
+                world.end = true;
                 return;
             default:
                 break;
@@ -222,12 +287,13 @@ int main(int argc, char** argv) {
         int genresProb[] = {3, 6, 1}; // The probability of each genre
         int genresSize_[] = {0, 4, 4, 4}; // The number of tracks for each genre
         std::discrete_distribution<int> genresDistribution(genresProb, genresProb + genresProbSize);
-        std::string genres[] = {"F", "MH", "ML", "P"}; // The genres of the music
+        const char* genres[] = {"F", "MH", "ML", "P"}; // The genres of the music
         std::unordered_map<std::string, int> length_ = { // The length of each track
             {"MH1", 10}, {"MH2", 16}, {"MH3", 16}, {"MH4", 8},
             {"ML1", 4}, {"ML2", 6}, {"ML3", 6}, {"ML4", 6},
             {"P1", 4}, {"P2", 8}, {"P3", 6}, {"P4", 6}
         };
+        std::default_random_engine rng(std::chrono::system_clock::now().time_since_epoch().count());
         music_th = std::thread([&]() {
             int n, genre;
             #ifdef __APPLE__
@@ -237,22 +303,19 @@ int main(int argc, char** argv) {
                     extendedProb.push_back(i+1);
                 }
             }
-            while (!end) {
+            while (!world.end) {
                 genre = extendedProb[rand() % extendedProb.size()];
                 n = (rand() % genresSize_[genre]) + 1;
-                std::string track = genres[genre] + std::to_string(n);
                 try {
                     char buf[1024];
-                    snprintf(buf, 1024, "afplay \"audio/%s.mp3\"", track.c_str());
+                    snprintf(buf, 1024, "afplay \"audio/%s%d.mp3\"", genres[genre], n);
                     if (system(buf))
                         throw std::runtime_error("afplay not found");
                 } catch (std::exception& e) {
-                    #if DEBUG
-                    debug << e.what() << std::endl;
-                    #endif
+                    trace(TRACE_ERROR, MUSIC_UNAVAILABLE, TRACE_NO_TYPE, 0, 0, 0);
                     return; // If the music can't be played, the thread ends
                 }
-                while (pause_) {
+                while (world.paused) {
                     std::this_thread::sleep_for(std::chrono::milliseconds(100));
                 }
             }
@@ -263,12 +326,13 @@ int main(int argc, char** argv) {
                 {0, 4, 6, 6, 6},
                 {0, 4, 8, 6, 6}
             };
-            while (!end) {
+            while (!world.end) {
                 genre = genresDistribution(rng);
                 n = (rand() % genresSize_[genre]) + 1;
-                std::string track = genres[genre] + std::to_string(n);
                 try {
-                    mciSendString((LPCSTR)("play audio/" + track + ".wav").c_str(), NULL, 0, NULL);
+                    char buf[1024];
+                    snprintf(buf, 1024, "play audio/%s%d.wav", genres[genre], n);
+                    mciSendString((LPCSTR)buf, NULL, 0, NULL);
                     int wait = length[genre][n];
                     wait *= 1000;
                     wait -= WIN_API_MUSIC_DELAY; // Some time is wasted in API calls, so we have to compensate for that
@@ -276,435 +340,204 @@ int main(int argc, char** argv) {
                 } catch (std::exception& e) {
                     return; // If the music can't be played, the thread ends
                 }
-                if (pause_) {
+                if (world.paused) {
                     PlaySound(NULL, 0, 0);
                     // break;
                 }
-                while (pause_) {
+                while (world.paused) {
                     std::this_thread::sleep_for(std::chrono::milliseconds(100));
                 }
             }
             #elif __linux__
-            while (!end) {
+            while (!world.end) {
                 genre = genresDistribution(rng);
                 n = (rand() % genresSize_[genre]) + 1;
-                std::string track = ((std::string)"audio/") + genres[genre] + std::to_string(n) + (std::string)".ogg";
+                char buf[1024]; // Formatted on the stack, the thread doesn't allocate between tracks
                 try {
-                    if (system(("ffplay -v 0 -nodisp -autoexit " + track).c_str())) {
+                    snprintf(buf, 1024, "ffplay -v 0 -nodisp -autoexit \"audio/%s%d.ogg\"", genres[genre], n);
+                    if (system(buf)) {
                         throw std::runtime_error("ffplay not found");
                     }
                 } catch (std::exception& e) {
-                    std::string wavTrack = genres[genre] + std::to_string(n);
                     try {
-                        char buf[1024];
-                        snprintf(buf, 1024, "aplay \"audio/%s.wav\"", wavTrack.c_str());
+                        snprintf(buf, 1024, "aplay \"audio/%s%d.wav\"", genres[genre], n);
                         if (system(buf)) {
-                            #if DEBUG
-                            debug << e.what() << std::endl;
-                            #endif
+                            trace(TRACE_ERROR, MUSIC_UNAVAILABLE, TRACE_NO_TYPE, 0, 0, 1);
                             throw std::runtime_error("aplay not found");
                         }
                     } catch (std::exception& e) {
-                        #if DEBUG
-                        debug << e.what() << std::endl;
-                        #endif
+                        trace(TRACE_ERROR, MUSIC_UNAVAILABLE, TRACE_NO_TYPE, 0, 0, 2);
                         return; // If the music can't be played, the thread ends
                     }
                 }
-                while (pause_) {
-                    if (end) return;
+                while (world.paused) {
+                    if (world.end) return;
                     std::this_thread::sleep_for(std::chrono::milliseconds(100));
                 }
             }
             #endif
         });
     }
-    for (unsigned i=0; !end; i++) {
+    MetricsServer metrics;
+    std::unique_ptr<CountingBuffer> countingBuffer; // Counts the output bytes per frame, only with the metrics
+    if (!metricsPath.empty()) {
+        if (!metrics.start(metricsPath)) {
+            std::cerr << "Could not serve the metrics on " << metricsPath << std::endl;
+            metricsPath.clear();
+        } else {
+            countingBuffer = std::make_unique<CountingBuffer>(std::cout.rdbuf());
+            std::cout.rdbuf(countingBuffer.get());
+        }
+    }
+    RewindBuffer rewindBuffer; // Always recording, so that the last minutes can be reviewed after the game is over
+    {
+        std::lock_guard<std::mutex> lock(world.mutex); // The input thread is already running
+        world.recordEvents = true; // Consumed at the end of every frame
+    }
+    traceFrame = startFrame;
+    trace(TRACE_INFO, GAME_STARTED, TRACE_NO_TYPE, 0, 0, hardcore + 2 * endless);
+    for (unsigned i=startFrame; !world.end; i++) {
         if (unofficial) {
-            while (pause_) {
+            while (world.paused) {
                 std::this_thread::sleep_for(std::chrono::milliseconds(100));
             } // So the game doesn't run while paused, and the speedrun is not affected, so it's unofficial
-        } else if (pause_) {
+        } else if (world.paused) {
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
             continue; // So the game keeps increasing the frame counter, and the speedrun is affected by the pause
         }
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        std::lock_guard<std::mutex> lock(inputOutputMutex);
-
-        Bullet::bullets.erase(
-            std::remove_if(
-                Bullet::bullets.begin(),
-                Bullet::bullets.end(),
-                [](const std::shared_ptr<Bullet>& bullet) {
-                    if (!bullet) return true;
-                    if (bullet->collided) {
-                        // Remove pawn from field before erasing
-                        field->erasePawn(bullet.get());
-                        return true;
-                    }
-                    return false;
-                }
-            ),
-            Bullet::bullets.end()
-        );
-        // removeNullptrs((std::vector<std::shared_ptr<Entity>>&)Bullet::bullets);
-        for (unsigned j=0; j<Bullet::bullets.size(); j++) {
-            if (j >= Bullet::bullets.size()) break;
-            std::shared_ptr<Bullet> bullet = Bullet::bullets[j];
-            if (bullet == nullptr) continue;
-            if (bullet->collided) continue;
-            bullet->move();
-        }
-        Bullet::bullets.erase(
-            std::remove_if(
-                Bullet::bullets.begin(),
-                Bullet::bullets.end(),
-                [](const std::shared_ptr<Bullet>& bullet) {
-                    if (!bullet) return true;
-                    if (bullet->collided) {
-                        // Remove pawn from field before erasing
-                        field->erasePawn(bullet.get());
-                        return true;
-                    }
-                    return false;
-                }
-            ),
-            Bullet::bullets.end()
-        );
-        // removeNullptrs((std::vector<std::shared_ptr<Entity>>&)Bullet::bullets);
-        // removeNullptrs((std::vector<std::shared_ptr<Entity>>&)EnemyBullet::enemyBullets);
-        EnemyBullet::enemyBullets.erase(
-            std::remove_if(
-                EnemyBullet::enemyBullets.begin(),
-                EnemyBullet::enemyBullets.end(),
-                [](const std::shared_ptr<EnemyBullet>& enemyBullet) {
-                    if (!enemyBullet) return true;
-                    if (enemyBullet->collided) {
-                        // Remove pawn from field before erasing
-                        field->erasePawn(enemyBullet.get());
-                        return true;
-                    }
-                    return false;
-                }
-            ),
-            EnemyBullet::enemyBullets.end()
-        );
-        for (unsigned j=0; j<EnemyBullet::enemyBullets.size(); j++) {
-            if (j >= EnemyBullet::enemyBullets.size()) break;
-            std::shared_ptr<EnemyBullet> enemyBullet = EnemyBullet::enemyBullets[j];
-            if (enemyBullet == nullptr) continue;
-            if (enemyBullet->collided) continue;
-            enemyBullet->move();
-        }
-        EnemyBullet::enemyBullets.erase(
-            std::remove_if(
-                EnemyBullet::enemyBullets.begin(),
-                EnemyBullet::enemyBullets.end(),
-                [](const std::shared_ptr<EnemyBullet>& enemyBullet) {
-                    if (!enemyBullet) return true;
-                    if (enemyBullet->collided) {
-                        // Remove pawn from field before erasing
-                        field->erasePawn(enemyBullet.get());
-                        return true;
-                    }
-                    return false;
-                }
-            ),
-            EnemyBullet::enemyBullets.end()
-        );
-
-        // removeNullptrs((std::vector<std::shared_ptr<Entity>>&)EnemyBullet::enemyBullets);
-        // removeNullptrs((std::vector<std::shared_ptr<Entity>>&)Zombie::zombies);
-        for (auto zombie : Zombie::zombies) {
-            if (Zombie::distribution(rng))
-                zombie->move();
-        }
-        // removeNullptrs((std::vector<std::shared_ptr<Entity>>&)Walker::walkers);
-        for (auto zombie : Zombie::zombies)
-            if (Zombie::shootDistribution(rng))
-                zombie->shoot();
-        // removeNullptrs((std::vector<std::shared_ptr<Entity>>&)Walker::walkers);
-        Walker::walkers.erase(
-            std::remove_if(
-                Walker::walkers.begin(),
-                Walker::walkers.end(),
-                [](const std::shared_ptr<Walker>& walker) {
-                    if (!walker) return true;
-                    if (walker->exploded) {
-                        // Remove pawn from field before erasing
-                        field->erasePawn(walker.get());
-                        return true;
-                    }
-                    return false;
-                }
-            ),
-            Walker::walkers.end()
-        );
-        for (auto walker : Walker::walkers) {
-            if (walker->exploded) continue;
-            if (Walker::distribution(rng))
-                walker->move();
-        }
-        Walker::walkers.erase(
-            std::remove_if(
-                Walker::walkers.begin(),
-                Walker::walkers.end(),
-                [](const std::shared_ptr<Walker>& walker) {
-                    if (!walker) return true;
-                    if (walker->exploded) {
-                        // Remove pawn from field before erasing
-                        field->erasePawn(walker.get());
-                        return true;
-                    }
-                    return false;
-                }
-            ),
-            Walker::walkers.end()
-        );
-        // removeNullptrs((std::vector<std::shared_ptr<Entity>>&)Mine::mines);
-        for (auto mine : Mine::mines)
-            mine->checkTrigger();
-        // removeNullptrs((std::vector<std::shared_ptr<Entity>>&)Worker::workers);        
-        std::vector<std::vector<unsigned short>> workersPositions(20, std::vector<unsigned short>()); // workersPositions[y] = {x1, x2, x3, ...} where the workers are
-        for (auto worker : Worker::workers) {
-            workersPositions[worker->getCoordinates().y].push_back(worker->getCoordinates().x);
-            if (worker->distribution(rng))
-                worker->produce();
-        }
-        // removeNullptrs((std::vector<std::shared_ptr<Entity>>&)Cannon::cannons);
-        for (auto worker : ArmedWorker::armedWorkers) {
-            if (worker->distribution(rng))
-                worker->produce();
-            worker->dodgeIfNeeded();
-        }
-
-        for (auto cannon : Cannon::cannons) {
-            cannon->recomputeDistribution(workersPositions);
-            if (cannon->distribution(rng))
-                cannon->fire();
-        }
-        // removeNullptrs((std::vector<std::shared_ptr<Entity>>&)Bomber::bombers);
-        Bomber::bombers.erase(
-            std::remove_if(
-                Bomber::bombers.begin(),
-                Bomber::bombers.end(),
-                [](const std::shared_ptr<Bomber>& bomber) {
-                    if (!bomber) return true;
-                    if (bomber->exploded) {
-                        // Remove pawn from field before erasing
-                        field->erasePawn(bomber.get());
-                        return true;
-                    }
-                    return false;
-                }
-            ),
-            Bomber::bombers.end()
-        );
-        for (unsigned j = 0; j < Bomber::bombers.size(); j++) {
-            std::shared_ptr<Bomber> bomber = Bomber::bombers[j];
-            if (bomber == nullptr) continue;
-            if (bomber->exploded) continue;
-            bomber->move();
-        }
-        try {
-            Queen::queen->move();
-        } catch (std::exception& e) {
-            // Nothing to do here
-        }
-        // removeNullptrs((std::vector<std::shared_ptr<Entity>>&)Wall::walls);
-        Wall::walls.erase(
-            std::remove_if(
-                Wall::walls.begin(),
-                Wall::walls.end(),
-                [](const std::shared_ptr<Wall>& wall) {
-                    if (!wall) return true;
-                    if (wall->strength == 0) {
-                        // Remove pawn from field before erasing
-                        field->erasePawn(wall.get());
-                        return true;
-                    }
-                    return false;
-                }
-            ),
-            Wall::walls.end()
-        );
-        for (unsigned j = 0; j < Wall::walls.size(); j++) {
-            std::shared_ptr<Wall> wall = Wall::walls[j];
-            if (wall == nullptr) continue;
-            if (wall->strength == 0) continue;
-        }
-        Wall::walls.erase(
-            std::remove_if(
-                Wall::walls.begin(),
-                Wall::walls.end(),
-                [](const std::shared_ptr<Wall>& wall) {
-                    if (!wall) return true;
-                    if (wall->strength == 0) {
-                        // Remove pawn from field before erasing
-                        field->erasePawn(wall.get());
-                        return true;
-                    }
-                    return false;
-                }
-            ),
-            Wall::walls.end()
-        );
-        // removeNullptrs((std::vector<std::shared_ptr<Entity>>&)Bullet::bullets);
-        std::vector<std::vector<std::shared_ptr<Mine>>::iterator> minesToRemove; // We can't remove mines while iterating over them, so we store the iterators of the mines to remove
-        for (unsigned j=0; j<Mine::mines.size(); j++) {
-            if (j >= Mine::mines.size()) break;
-            if (Mine::mines[j] == nullptr) continue;
-            if (Mine::mines[j]->triggered) {
-                Mine::mines[j]->explode();
-                minesToRemove.push_back(Mine::mines.begin() + j);
-            }
-        }
-        for (auto it : minesToRemove) {
-            Mine::mines.erase(it);
-            field->erasePawn((*it).get());
-        }
-        minesToRemove.clear();
-
-        if (i % 100 == 0) {
-            unsigned short y = rand() % 20;
-            if (Queen::queen->getCoordinates().y != y) {
-                sista::Coordinates spawn{y, 49};
-                if (field->isOccupied(spawn)) continue;
-                std::shared_ptr<Walker> walker = std::make_shared<Walker>(spawn);
-                Walker::walkers.push_back(walker);
-                field->addPrintPawn(walker);
-            }
-        }
-        if (i % 200 == 0) {
-            unsigned short y = rand() % 20;
-            if (Queen::queen->getCoordinates().y != y) {
-                sista::Coordinates spawn{y, 49};
-                if (field->isOccupied(spawn)) continue;
-                std::shared_ptr<Zombie> zombie = std::make_shared<Zombie>(spawn);
-                Zombie::zombies.push_back(zombie);
-                field->addPrintPawn(zombie);
-            }
-        }
-        if (hardcore) {
-            // The point of the game is to survive as long as possible, so the spawning rate of the enemies increases over time
-            // The hordes of enemies are spawned every 500 frames, but the number of enemies in each horde increases over time
-            if (i % 500 == 250) {
-                for (unsigned short j=0; j<i/100; j++) {
-                    unsigned short y = rand() % 20;
-                    if (Queen::queen->getCoordinates().y != y) {
-                        std::shared_ptr<Walker> walker = std::make_shared<Walker>(sista::Coordinates{y, 49});
-                        Walker::walkers.push_back(walker);
-                        field->addPrintPawn(walker);
-                    }
-                }
-                for (unsigned short j=0; j<i/200; j++) {
-                    unsigned short y = rand() % 20;
-                    if (Queen::queen->getCoordinates().y != y) {
-                        std::shared_ptr<Zombie> zombie = std::make_shared<Zombie>(sista::Coordinates{y, 49});
-                        Zombie::zombies.push_back(zombie);
-                        field->addPrintPawn(zombie);
-                    }
-                }
-            }
-            // Too many zombies increase the probability of segfaults, so every REPOPULATE frames we empty and then repopulate the field
-            if (i % REPOPULATE == REPOPULATE - 1) {
-                field->clear();
-                field->addPrintPawn(Player::player);
-                field->addPrintPawn(Queen::queen);
-                for (auto wall : Wall::walls) {
-                    field->addPrintPawn(wall);
-                }
-                for (auto zombie : Zombie::zombies) {
-                    field->addPrintPawn(zombie);
-                }
-                for (auto walker : Walker::walkers) {
-                    field->addPrintPawn(walker);
-                }
-                for (auto mine : Mine::mines) {
-                    field->addPrintPawn(mine);
-                }
-                for (auto cannon : Cannon::cannons) {
-                    field->addPrintPawn(cannon);
-                }
-                for (auto worker : Worker::workers) {
-                    field->addPrintPawn(worker);
-                }
-                for (auto worker : ArmedWorker::armedWorkers) {
-                    field->addPrintPawn(worker);
-                }
-                for (auto bomber : Bomber::bombers) {
-                    field->addPrintPawn(bomber);
-                }
-            }
+        std::lock_guard<std::mutex> lock(world.mutex);
+        FrameSample sample; // Only published with the metrics, taking it costs a couple of counter reads
+        auto frameStart = std::chrono::steady_clock::now();
+        unsigned long long allocationsBefore = heapAllocations.load(std::memory_order_relaxed);
+        unsigned long long outputBefore = countingBuffer ? countingBuffer->bytes.load(std::memory_order_relaxed) : 0;
+
+        if (bot)
+            applyAction(world, bot->decide(world)); // The bot gives one command per frame, as through the input thread
+        if (!world.update(i, hardcore)) { // A wave found its cell taken, the entities still moved
+            rewindBuffer.record(world, i);
+            continue; // Only the rendering and the checks are skipped
         }
         if (endless) {
             // The game is endless, so the queen regenerates life
-            Queen::queen->life = 9;
+            world.queen->life = 9;
+        }
+        world.queen->showLife();
+        world.field->rePrintPawn(world.queen.get());
+        // The simulation only reports what happened, what is seen and heard of it is decided here
+        for (const GameEvent& event : world.events) {
+            sample.events[event.kind]++;
+            switch (event.kind) {
+            case WALL_DESTROYED: { // Shown destroyed until the next frame removes it, if it wasn't removed already
+                Entity* wall = (Entity*)world.field->getPawn(event.coordinates);
+                if (wall != nullptr && wall->type == Type::WALL)
+                    world.field->rePrintPawn(wall);
+                break;
+            }
+            case AMMO_EMPTY:
+                std::cout << "\7"; // Terminal bell
+                break;
+            default:
+                break;
+            }
         }
-        Queen::queen->setSymbol('0' + Queen::queen->life);
-        field->rePrintPawn(Queen::queen.get());
+        world.events.clear();
         if (i % 10 == 0) {
             sista::clearScreen();
-            field->print(border);
+            world.field->print(border);
         }
         // Statistics
-        Queen::queenStyle.apply();
+        styles[QUEEN_STYLE].settings.apply();
         cursor.goTo(8, 55);
         std::cout << "Frame elapsed: " << i << " ";
         cursor.goTo(10, 55);
-        std::cout << "Ammonitions: " << Player::player->ammonitions << "    ";
+        std::cout << "Ammonitions: " << world.player->ammonitions << "    ";
         cursor.goTo(12, 55);
-        std::cout << "Life: " << Queen::queen->life;
+        std::cout << "Life: " << world.queen->life;
         if (!unofficial) {
             cursor.goTo(14, 55);
             std::cout << START_AMMONITION; // The official run should show the starting ammonition
         }
+        if (saveRequested) {
+            saveRequested = false;
+            snapshotInfo.frame = i + 1; // The snapshot is taken at the end of the frame, so the next one is i + 1
+            snapshotInfo.hardcore = hardcore;
+            snapshotInfo.endless = endless;
+            cursor.goTo(16, 55);
+            if (saveSnapshot(world, SNAPSHOT_FILE, snapshotInfo)) {
+                std::cout << "Saved " << snapshotInfo.bytes << "B in " << snapshotInfo.elapsed.count() << "us    ";
+            } else {
+                std::cout << "Could not save " << SNAPSHOT_FILE << "    ";
+            }
+        } else if (!loadPath.empty() && i == startFrame) {
+            cursor.goTo(16, 55);
+            std::cout << "Loaded " << snapshotInfo.bytes << "B in " << snapshotInfo.elapsed.count() << "us";
+        }
+        if (checkpointPeriod > 0 && i > startFrame && (i - startFrame) % checkpointPeriod == 0) {
+            SnapshotInfo checkpointInfo;
+            checkpointInfo.frame = i + 1;
+            checkpointInfo.hardcore = hardcore;
+            checkpointInfo.endless = endless;
+            cursor.goTo(20, 55);
+            if (checkpointer.take(world, checkpointInfo)) { // The size and the write time are the ones of the previous checkpoint
+                std::cout << "Checkpoint stall " << checkpointer.lastStall.count() / 1000 << "us, max " << checkpointer.maxStall.count() / 1000 << "us, ";
+                std::cout << checkpointer.lastBytes << "B in " << checkpointer.lastWriteMicroseconds << "us    ";
+            } else {
+                std::cout << "Checkpoint skipped, " << checkpointer.skipped << " so far    ";
+            }
+        }
         std::cout << std::flush;
 
-        #if SCAN_FOR_NULLPTRS
-        // At the end of the frame we check if in the Field there is any Entity which isn't in any of the lists
-        std::vector<sista::Coordinates> coordinates;
-        for (unsigned short j=0; j<20; j++) {
-            for (unsigned short i=0; i<50; i++) {
-                Entity* pawn = (Entity*)field->getPawn(j, i);
-                if (pawn == nullptr) continue;
-
-                // Helper lambda to check if a raw pointer is in a vector of shared_ptr
-                auto contains_raw_ptr = [pawn](const auto& vec) {
-                    return std::find_if(vec.begin(), vec.end(),
-                        [pawn](const auto& sp) { return sp.get() == pawn; }) != vec.end();
-                };
-
-                if (!contains_raw_ptr(Bullet::bullets) &&
-                    !contains_raw_ptr(EnemyBullet::enemyBullets) &&
-                    !contains_raw_ptr(Zombie::zombies) &&
-                    !contains_raw_ptr(Walker::walkers) &&
-                    !contains_raw_ptr(Wall::walls) &&
-                    !contains_raw_ptr(Mine::mines) &&
-                    !contains_raw_ptr(Cannon::cannons) &&
-                    !contains_raw_ptr(Worker::workers) &&
-                    !contains_raw_ptr(ArmedWorker::armedWorkers) &&
-                    !contains_raw_ptr(Bomber::bombers) &&
-                    pawn != Player::player.get() && pawn != Queen::queen.get()) {
-                    coordinates.push_back(pawn->getCoordinates());
-                    #if DEBUG
-                    debug << "Erasing " << pawn << " at {" << pawn->getCoordinates().y;
-                    debug << ", " << pawn->getCoordinates().x << "}" << std::endl;
-                    debug << "\t" << typeid(*pawn).name() << std::endl;
-                    #endif
-                }
+        #if INTEGRITY_CHECK_PERIOD
+        // Every INTEGRITY_CHECK_PERIOD frames the field is checked against the entity lists, the mismatches are only reported
+        if (i % INTEGRITY_CHECK_PERIOD == 0) {
+            static const char* kinds[] = {"unlisted", "missing", "duplicate"};
+            IntegrityReport report;
+            bool consistent = world.checkIntegrity(report);
+            cursor.goTo(18, 55);
+            if (!consistent) {
+                const IntegrityMismatch& first = report.first[0];
+                std::cout << "Integrity: " << report.mismatches << " mismatches, " << kinds[first.kind] << " ";
+                std::cout << typeNames[first.type] << " at {" << first.coordinates.y << ", " << first.coordinates.x << "}    ";
+            } else {
+                std::cout << std::string(40, ' '); // Clears the report of a previous check
             }
-        }
-        for (auto coord : coordinates) {
-            field->erasePawn(coord);
+            std::cout << std::flush;
         }
         #endif
+        rewindBuffer.record(world, i);
+        if (countingBuffer) {
+            sample.frame = i;
+            sample.end = std::chrono::steady_clock::now();
+            sample.duration = sample.end - frameStart;
+            sample.allocations = heapAllocations.load(std::memory_order_relaxed) - allocationsBefore;
+            sample.outputBytes = countingBuffer->bytes.load(std::memory_order_relaxed) - outputBefore;
+            countEntities(world, sample);
+            metrics.publish(sample);
+        }
+    }
+    checkpointer.stop();
+    trace(TRACE_INFO, GAME_OVER, Type::QUEEN, world.queen->getCoordinates().y, world.queen->getCoordinates().x, world.queen->life);
+    if (countingBuffer) {
+        metrics.stop();
+        std::cout.rdbuf(countingBuffer->destination);
     }
     if (music) {
         music_th.join();
     }
     th.join();
+    tracer.stop();
     flushInput();
+    cursor.goTo(HEIGHT + 3, 0);
+    std::cout << "Press 'r' to rewind the last " << rewindBuffer.size() << " frames, any other key to quit" << std::flush;
+    #if defined(_WIN32) or defined(__linux__)
+    if (getch() == 'r') {
+        rewindViewer(rewindBuffer, []() -> char { return getch(); });
+    #elif __APPLE__
+    if (getchar() == 'r') {
+        rewindViewer(rewindBuffer, []() -> char { return getchar(); });
+    #endif
+    }
     cursor.goTo(WIDTH + 2, 0); // Move the cursor to the bottom of the screen, so the terminal is not left in a weird state
     #ifdef __APPLE__
     tcsetattr(0, TCSANOW, &orig_termios);
@@ -764,15 +597,15 @@ void tutorial() {
     std::cout << "\t\t\t\tQ to skip\n\n";
 
     std::cout << "\tYou are the red \x1b[31m$\x1b[0m symbol and you have to kill the ";
-    Queen::queenStyle.apply();
+    styles[QUEEN_STYLE].settings.apply();
     std::cout << "9\x1b[0m queen to win.\n";
     std::cout << "\tThe queen defends herself by spawning shooting ";
-    Zombie::zombieStyle.apply();
+    styles[ZOMBIE_STYLE].settings.apply();
     std::cout << "Z\x1b[0m zombies and walking ";
-    Walker::walkerStyle.apply();
+    styles[WALKER_STYLE].settings.apply();
     std::cout << "Z\x1b[0m zombies.\n";
     std::cout << "\tThe queen also spawns ";
-    Wall::wallStyle.apply();
+    styles[WALL_STYLE].settings.apply();
     std::cout << "=\x1b[0m walls to protect herself when hit.\n";
     std::cout << "\tYou must kill the queen as fast as possible, because the zombies will keep spawning.\n\n";
 
@@ -828,843 +661,3 @@ void tutorial() {
         getchar();
     #endif
 }
-
-std::unordered_map<Direction, sista::Coordinates> directionMap = {
-    {Direction::UP, {(unsigned short)-1, 0}},
-    {Direction::RIGHT, {0, 1}},
-    {Direction::DOWN, {1, 0}},
-    {Direction::LEFT, {0, (unsigned short)-1}}
-};
-std::unordered_map<Direction, char> directionSymbol = {
-    {Direction::UP, '^'},
-    {Direction::RIGHT, '>'},
-    {Direction::DOWN, 'v'},
-    {Direction::LEFT, '<'}
-};
-std::mt19937 rng(std::chrono::system_clock::now().time_since_epoch().count());
-
-Entity::Entity(char symbol, sista::Coordinates coordinates, sista::ANSISettings& settings, Type type) : sista::Pawn(symbol, coordinates, settings), type(type) {}
-Entity::Entity() : sista::Pawn(' ', sista::Coordinates(0, 0), Wall::wallStyle), type(Type::PLAYER) {}
-
-sista::ANSISettings Bullet::bulletStyle = {
-    sista::ForegroundColor::MAGENTA,
-    sista::BackgroundColor::BLACK,
-    sista::Attribute::BRIGHT
-};
-void Bullet::removeBullet(std::shared_ptr<Bullet> bullet) {
-    #if DEBUG
-    debug << "Removing bullet " << bullet << std::endl;
-    debug << "\tAt coordinates {" << bullet->getCoordinates().y << ", " << bullet->getCoordinates().x << "}" << std::endl;
-    debug << "\tAddress: " << bullet.get() << std::endl;
-    debug << "\tIsNull: " << (int)(bullet.get() == nullptr) << std::endl;
-    debug << "\tShared pointer use count: " << bullet.use_count() << std::endl;
-    debug << "\tBefore removal there are " << Bullet::bullets.size() << " bullets" << std::endl;
-    #endif
-    Bullet::bullets.erase(std::find(Bullet::bullets.begin(), Bullet::bullets.end(), bullet));
-    field->erasePawn(bullet.get());
-    #if DEBUG
-    debug << "\tAfter removal there are " << Bullet::bullets.size() << " bullets" << std::endl;
-    #endif
-}
-void Bullet::removeBullet(Bullet* bullet) {
-    #if DEBUG
-    debug << "Removing bullet " << bullet << std::endl;
-    debug << "\tAt coordinates {" << bullet->getCoordinates().y << ", " << bullet->getCoordinates().x << "}" << std::endl;
-    debug << "\tAddress: " << bullet << std::endl;
-    debug << "\tIsNull: " << (int)(bullet == nullptr) << std::endl;
-    debug << "\tBefore removal there are " << Bullet::bullets.size() << " bullets" << std::endl;
-    #endif
-    auto it = std::find_if(Bullet::bullets.begin(), Bullet::bullets.end(),
-        [bullet](const std::shared_ptr<Bullet>& b) { return b.get() == bullet; });
-    if (it != Bullet::bullets.end()) {
-        Bullet::bullets.erase(it);
-        field->erasePawn(bullet);
-    }
-    #if DEBUG
-    debug << "\tAfter removal there are " << Bullet::bullets.size() << " bullets" << std::endl;
-    #endif
-}
-Bullet::Bullet() : Entity(' ', {0, 0}, bulletStyle, Type::BULLET), direction(Direction::RIGHT), speed(1) {}
-Bullet::Bullet(sista::Coordinates coordinates, Direction direction) : Entity(directionSymbol[direction], coordinates, bulletStyle, Type::BULLET), direction(direction), speed(1) {}
-Bullet::Bullet(sista::Coordinates coordinates, Direction direction, unsigned short speed) : Entity(directionSymbol[direction], coordinates, bulletStyle, Type::BULLET), direction(direction), speed(speed) {}
-void Bullet::move() {
-    sista::Coordinates nextCoordinates = coordinates + directionMap[direction]*speed;
-    if (field->isOutOfBounds(nextCoordinates)) {
-        this->collided = true; // Marking for removal
-        return;
-    } else if (field->isFree(nextCoordinates)) {
-        field->movePawn(this, nextCoordinates);
-        coordinates = nextCoordinates;
-        return;
-    } else { // Something was hitten
-        Entity* hitten = (Entity*)field->getPawn(nextCoordinates);
-        if (hitten->type == Type::WALL) {
-            Wall* wall = (Wall*)hitten;
-            wall->strength--;
-            if (wall->strength == 0) {
-                wall->setSymbol('@'); // Change the symbol to '@' to indicate that the wall was destroyed
-                field->rePrintPawn(wall); // It will be reprinted in the next frame and then removed because of (strength == 0)
-            }
-        } else if (hitten->type == Type::ZOMBIE) {
-            Zombie::removeZombie((Zombie*)hitten);
-        } else if (hitten->type == Type::WALKER) {
-            Walker::removeWalker((Walker*)hitten);
-        } else if (hitten->type == Type::BULLET) {
-            ((Bullet*)hitten)->collided = true;
-            // Bullet::removeBullet((Bullet*)hitten);
-            return;
-        } else if (hitten->type == Type::ENEMYBULLET) {
-            // When two bullets collide, their "collided" attribute is set to true
-            ((EnemyBullet*)hitten)->collided = true;
-            collided = true;
-            return;
-        } else if (hitten->type == Type::MINE) {
-            Mine* mine = (Mine*)hitten;
-            mine->triggered = true;
-        } else if (hitten->type == Type::CANNON) {
-            Cannon* cannon = (Cannon*)hitten;
-            // Makes the cannon fire
-            cannon->fire();
-        } else if (hitten->type == Type::QUEEN) {
-            Queen* mother = (Queen*)hitten;
-            mother->life--;
-            field->rePrintPawn(mother);
-            mother->createWall();
-            if (mother->life == 0) {
-                // win();
-                end = true;
-            }
-        }
-        this->collided = true; // Marking for removal
-    }
-}
-
-
-sista::ANSISettings EnemyBullet::enemyBulletStyle = {
-    sista::ForegroundColor::GREEN,
-    sista::BackgroundColor::BLACK,
-    sista::Attribute::BRIGHT
-};
-EnemyBullet::EnemyBullet(sista::Coordinates coordinates, Direction direction, unsigned short speed) : Entity(directionSymbol[direction], coordinates, enemyBulletStyle, Type::ENEMYBULLET), direction(direction), speed(speed) {}
-EnemyBullet::EnemyBullet(sista::Coordinates coordinates, Direction direction) : Entity(directionSymbol[direction], coordinates, enemyBulletStyle, Type::ENEMYBULLET), direction(direction), speed(1) {}
-EnemyBullet::EnemyBullet() : Entity(' ', {0, 0}, enemyBulletStyle, Type::ENEMYBULLET), direction(Direction::UP), speed(1) {}
-void EnemyBullet::removeEnemyBullet(std::shared_ptr<EnemyBullet> enemyBullet) {
-    EnemyBullet::enemyBullets.erase(std::find(EnemyBullet::enemyBullets.begin(), EnemyBullet::enemyBullets.end(), enemyBullet));
-    field->erasePawn(enemyBullet.get());
-}
-void EnemyBullet::removeEnemyBullet(EnemyBullet* enemyBullet) {
-    for (auto it = EnemyBullet::enemyBullets.begin(); it != EnemyBullet::enemyBullets.end(); ++it) {
-        if (it->get() == enemyBullet) {
-            field->erasePawn(enemyBullet);
-            EnemyBullet::enemyBullets.erase(it);
-            return;
-        }
-    }
-}
-void EnemyBullet::move() { // Pretty sure there's a segfault here
-    sista::Coordinates nextCoordinates = coordinates + directionMap[direction]*speed;
-    if (field->isOutOfBounds(nextCoordinates)) {
-        this->collided = true; // Mark for removal
-        return;
-    } else if (field->isFree(nextCoordinates)) {
-        field->movePawn(this, nextCoordinates);
-        coordinates = nextCoordinates;
-        return;
-    } else { // Something was hitten
-        Entity* hitten = (Entity*)field->getPawn(nextCoordinates);
-        if (hitten->type == Type::PLAYER) {
-            // lose();
-            end = true;
-        } else if (hitten->type == Type::WALL) {
-            Wall* wall = (Wall*)hitten;
-            wall->strength--;
-            if (wall->strength == 0) {
-                wall->setSymbol('@'); // Change the symbol to '@' to indicate that the wall was destroyed
-                field->rePrintPawn(wall); // It will be reprinted in the next frame and then removed because of (strength == 0)
-            }
-        } else if (hitten->type == Type::BULLET) {
-            ((Bullet*)hitten)->collided = true;
-            collided = true;
-            return;
-        } else if (hitten->type == Type::ZOMBIE || hitten->type == Type::WALKER) {
-            // No friendly fire
-        } if (hitten->type == Type::ENEMYBULLET) {
-            collided = true;
-            return;
-            // EnemyBullet::removeEnemyBullet((EnemyBullet*)hitten);
-        } else if (hitten->type == Type::MINE) {
-            Mine* mine = (Mine*)hitten;
-            mine->triggered = true;
-        } else if (hitten->type == Type::CANNON) { // The cannon is destroyed by the enemy bullet
-            Cannon::removeCannon((Cannon*)hitten);
-        } else if (hitten->type == Type::WORKER) {
-            Worker::removeWorker((Worker*)hitten);
-        } else if (hitten->type == Type::ARMED_WORKER) {
-            ArmedWorker::removeArmedWorker((ArmedWorker*)hitten);
-        } else if (hitten->type == Type::BOMBER) {
-            Bomber::removeBomber((Bomber*)hitten);
-        }
-        this->collided = true; // Mark for removal
-    }
-}
-
-sista::ANSISettings Player::playerStyle = {
-    sista::ForegroundColor::RED,
-    sista::BackgroundColor::BLACK,
-    sista::Attribute::BRIGHT
-};
-Player::Player(sista::Coordinates coordinates) : Entity('$', coordinates, playerStyle, Type::PLAYER), weapon(Type::BULLET), ammonitions(START_AMMONITION) {}
-Player::Player() : Entity('$', {0, 0}, playerStyle, Type::PLAYER), weapon(Type::BULLET), ammonitions(START_AMMONITION) {}
-void Player::move(Direction direction) {
-    sista::Coordinates nextCoordinates = coordinates + directionMap[direction];
-    if (field->isOutOfBounds(nextCoordinates) || !field->isFree(nextCoordinates) || nextCoordinates.x >= 30) {
-        return; // No complications, if you can't move there just pretend the command was never given
-    }
-    field->movePawn(this, nextCoordinates);
-    coordinates = nextCoordinates;
-}
-void Player::shoot(Direction direction) {
-    sista::Coordinates spawn = this->coordinates + directionMap[direction];
-    if (!field->isFree(spawn)) {
-        return; // No complications, if you can't spawn something there just pretend the command was never given
-    }
-    if (Player::player->ammonitions <= 0) {
-        std::cout << "\7";
-        return; // No complications, if you can't spawn something there just pretend the command was never given
-    }
-    switch (weapon) {
-    case Type::BULLET: {
-        Player::player->ammonitions--;
-        std::shared_ptr<Bullet> newbullet = std::make_shared<Bullet>(spawn, direction);
-        Bullet::bullets.push_back(newbullet);
-        field->addPrintPawn(newbullet);
-        break;
-    }
-    case Type::MINE: {
-        if (Player::player->ammonitions < 3)
-            return;
-        Player::player->ammonitions -= 3;
-        std::shared_ptr<Mine> newmine = std::make_shared<Mine>(spawn);
-        Mine::mines.push_back(newmine);
-        field->addPrintPawn(newmine);
-        break;
-    }
-    case Type::CANNON: {
-        if (Player::player->ammonitions < 5)
-            return;
-        Player::player->ammonitions -= 5;
-        std::shared_ptr<Cannon> newcannon = std::make_shared<Cannon>(spawn, CANNON_FIRE_PERIOD);
-        Cannon::cannons.push_back(newcannon);
-        field->addPrintPawn(newcannon);
-        break;
-    }
-    case Type::BOMBER: {
-        if (Player::player->ammonitions < 7)
-            return;
-        Player::player->ammonitions -= 7;
-        std::shared_ptr<Bomber> newbomber = std::make_shared<Bomber>(spawn);
-        Bomber::bombers.push_back(newbomber);
-        field->addPrintPawn(newbomber);
-        break;
-    }
-    case Type::WORKER: {
-        if (Player::player->ammonitions < 5)
-            return;
-        Player::player->ammonitions -= 5;
-        std::shared_ptr<Worker> newworker = std::make_shared<Worker>(spawn, WORKER_PRODUCTION_PERIOD);
-        Worker::workers.push_back(newworker);
-        field->addPrintPawn(newworker);
-        break;
-    }
-    case Type::ARMED_WORKER: {
-        if (Player::player->ammonitions < 8)
-            return;
-        Player::player->ammonitions -= 8;
-        std::shared_ptr<ArmedWorker> newworker = std::make_shared<ArmedWorker>(spawn, WORKER_PRODUCTION_PERIOD);
-        ArmedWorker::armedWorkers.push_back(newworker);
-        field->addPrintPawn(newworker);
-        break;
-    }
-    case Type::WALL: {
-        if (Player::player->ammonitions < 1)
-            return;
-        Player::player->ammonitions -= 1;
-        std::shared_ptr<Wall> newwall = std::make_shared<Wall>(spawn, 2);
-        Wall::walls.push_back(newwall);
-        field->addPrintPawn(newwall);
-        break;
-    }
-    default:
-        break;
-    }
-}
-
-sista::ANSISettings Zombie::zombieStyle = {
-    sista::ForegroundColor::BLACK,
-    sista::BackgroundColor::GREEN,
-    sista::Attribute::FAINT
-};
-void Zombie::removeZombie(std::shared_ptr<Zombie> zombie) {
-    Zombie::zombies.erase(std::find(Zombie::zombies.begin(), Zombie::zombies.end(), zombie));
-    field->erasePawn(zombie.get());
-}
-void Zombie::removeZombie(Zombie* zombie) {
-    auto it = std::find_if(Zombie::zombies.begin(), Zombie::zombies.end(),
-        [zombie](const std::shared_ptr<Zombie>& z) { return z.get() == zombie; });
-    if (it != Zombie::zombies.end()) {
-        field->erasePawn(zombie);
-        Zombie::zombies.erase(it);
-    }
-}
-Zombie::Zombie(sista::Coordinates coordinates) : Entity('Z', coordinates, zombieStyle, Type::ZOMBIE) {}
-Zombie::Zombie() : Entity('Z', {0, 0}, zombieStyle, Type::ZOMBIE) {}
-void Zombie::move() { // Zombies mostly move vertically and stay defending the mother
-    sista::Coordinates nextCoordinates;
-    // The zombie may move towards the player if it's in the same row, but it may also move the other way
-    if (Player::player->getCoordinates().y == coordinates.y) {
-        // Player.x is always < Zombie.x, so no need to check that
-        nextCoordinates = coordinates + directionMap[Direction::LEFT];
-        // If the Zombie is too left, it will move right
-        if (coordinates.x < 30) {
-            nextCoordinates = coordinates + directionMap[Direction::RIGHT];
-        }
-    } else {
-        if (rand() % 2 == 0) {
-            nextCoordinates = coordinates + directionMap[Direction::DOWN];
-        } else {
-            nextCoordinates = coordinates + directionMap[Direction::UP];
-        }
-    }
-    if (field->isFree(nextCoordinates)) {
-        field->movePawn(this, nextCoordinates);
-        coordinates = nextCoordinates;
-    }
-}
-void Zombie::shoot() {
-    sista::Coordinates spawn = coordinates + directionMap[Direction::LEFT];
-    if (!field->isFree(spawn)) {
-        return; // No complications, if you can't spawn something there just pretend the command was never given
-    }
-    std::shared_ptr<EnemyBullet> newbullet = std::make_shared<EnemyBullet>(spawn, Direction::LEFT);
-    EnemyBullet::enemyBullets.push_back(newbullet);
-    field->addPrintPawn(newbullet);
-}
-
-sista::ANSISettings Queen::queenStyle = {
-    sista::ForegroundColor::BLACK,
-    sista::BackgroundColor::RED,
-    sista::Attribute::BRIGHT
-};
-Queen::Queen(sista::Coordinates coordinates) : Entity('9', coordinates, queenStyle, Type::QUEEN), life(9) {}
-Queen::Queen() : Entity('9', {0, 0}, queenStyle, Type::QUEEN), life(9) {}
-void Queen::move() {
-    // Queen's movement is only vertical and it is always near the center of its side {10, 49}
-    if (rand() % 10 == 0) {
-        if (coordinates.y < 6) return;
-        sista::Coordinates nextCoordinates = coordinates + directionMap[Direction::UP];
-        if (field->isFree(nextCoordinates)) {
-            field->movePawn(this, nextCoordinates);
-            coordinates = nextCoordinates;
-        }
-    } else if (rand() % 10 == 1) {
-        if (coordinates.y > 14) return;
-        sista::Coordinates nextCoordinates = coordinates + directionMap[Direction::DOWN];
-        if (field->isFree(nextCoordinates)) {
-            field->movePawn(this, nextCoordinates);
-            coordinates = nextCoordinates;
-        }
-    }
-}
-void Queen::createWall() {
-    // First determine the length of the wall
-    unsigned short length = rand() % 3 + 3; // in range [3, 5]
-    // Then determine the position of the wall (the center of the wall is on the y coordinate of the queen)
-    unsigned short y = coordinates.y;
-    // Then search for an x coordinate which is free
-    unsigned short x = 48;
-    for (; x >= 30; x--) {
-        // We need to check all the cells in range {[y-length/2, y+1+length/2], x}
-        bool free = true;
-        for (unsigned short j=y-length/2; j<=y+1+length/2; j++) {
-            if (!field->isFree(j, x)) {
-                free = false;
-                break;
-            }
-        }
-        if (free) break;
-    }
-    if (x <= 30) return; // No free space to create the wall
-    // Now we can create the wall
-    for (unsigned short j=y-length/2; j<=y+1+length/2; j++) {
-        std::shared_ptr<Wall> wall = std::make_shared<Wall>(sista::Coordinates{j, x}, 1);
-        Wall::walls.push_back(wall);
-        field->addPrintPawn(wall);
-    }
-}
-
-sista::ANSISettings Wall::wallStyle = {
-    sista::ForegroundColor::YELLOW,
-    sista::BackgroundColor::BLACK,
-    sista::Attribute::BRIGHT
-};
-void Wall::removeWall(std::shared_ptr<Wall> wall) {
-    Wall::walls.erase(std::find(Wall::walls.begin(), Wall::walls.end(), wall));
-    field->erasePawn(wall.get());
-}
-Wall::Wall(sista::Coordinates coordinates, short int strength) : Entity('=', coordinates, wallStyle, Type::WALL), strength(strength) {}
-Wall::Wall() : Entity('=', {0, 0}, wallStyle, Type::WALL), strength(3) {}
-
-sista::ANSISettings Mine::mineStyle = {
-    sista::ForegroundColor::MAGENTA,
-    sista::BackgroundColor::BLACK,
-    sista::Attribute::BLINK
-};
-void Mine::removeMine(std::shared_ptr<Mine> mine) {
-    Mine::mines.erase(std::find(Mine::mines.begin(), Mine::mines.end(), mine));
-    field->erasePawn(mine.get());
-}
-Mine::Mine(sista::Coordinates coordinates) : Entity('*', coordinates, mineStyle, Type::MINE), triggered(false) {}
-Mine::Mine() : Entity('*', {0, 0}, mineStyle, Type::MINE), triggered(false) {}
-bool Mine::checkTrigger() {
-    for (int j=-1; j<=1; j++) {
-        for (int i=-1; i<=1; i++) {
-            if (i == 0 && j == 0) continue;
-            sista::Coordinates nextCoordinates = coordinates + sista::Coordinates(j, i);
-            if (field->isOutOfBounds(nextCoordinates)) continue;
-            Entity* neighbor = (Entity*)field->getPawn(nextCoordinates);
-            if (neighbor == nullptr) {
-                continue;
-            } else if (neighbor->type == Type::ZOMBIE || neighbor->type == Type::WALKER) {
-                trigger();
-                return true;
-            }
-        }
-    }
-    return false;
-}
-void Mine::trigger() {
-    triggered = true;
-    symbol = '%';
-    settings.foregroundColor = sista::ForegroundColor::WHITE;
-    settings.attribute = sista::Attribute::BRIGHT;
-    field->rePrintPawn(this);
-}
-void Mine::explode() {
-    for (int j=-2; j<=2; j++) {
-        for (int i=-2; i<=2; i++) {
-            if (i == 0 && j == 0) continue;
-            sista::Coordinates nextCoordinates = coordinates + sista::Coordinates(j, i);
-            if (field->isOutOfBounds(nextCoordinates)) {
-                continue;
-            }
-            Entity* neighbor = (Entity*)field->getPawn(nextCoordinates);
-            if (neighbor == nullptr) {
-                continue;
-            } else if (neighbor->type == Type::ZOMBIE) {
-                Zombie::removeZombie((Zombie*)neighbor);
-            } else if (neighbor->type == Type::WALKER) {
-                Walker::removeWalker((Walker*)neighbor);
-            } else if (neighbor->type == Type::ENEMYBULLET) {
-                EnemyBullet::removeEnemyBullet((EnemyBullet*)neighbor);
-            } else if (neighbor->type == Type::MINE) {
-                Mine* mine = (Mine*)neighbor;
-                mine->triggered = true;
-            } else if (neighbor->type == Type::CANNON) {
-                Cannon::removeCannon((Cannon*)neighbor);
-            } else if (neighbor->type == Type::QUEEN) {
-                Queen* mother = (Queen*)neighbor;
-                mother->life--;
-                field->rePrintPawn(mother);
-                mother->createWall();
-                if (mother->life == 0) {
-                    // win();
-                    end = true;
-                }
-            } else if (neighbor->type == Type::WALL) {
-                Wall* wall = (Wall*)neighbor;
-                int damage = rand() % 3 + 1;
-                if (wall->strength <= damage) {
-                    wall->strength = 0;
-                    wall->setSymbol('@'); // Change the symbol to '@' to indicate that the wall was destroyed
-                    field->rePrintPawn(wall); // It will be reprinted in the next frame and then removed because of (strength == 0)
-                } else {
-                    wall->strength -= damage;
-                }
-            }
-        }
-    }
-}
-
-sista::ANSISettings Cannon::cannonStyle = {
-    sista::ForegroundColor::RED,
-    sista::BackgroundColor::BLACK,
-    sista::Attribute::BRIGHT
-};
-std::bernoulli_distribution Cannon::distribution(1.0/CANNON_FIRE_PERIOD);
-void Cannon::removeCannon(std::shared_ptr<Cannon> cannon) {
-    Cannon::cannons.erase(std::find(Cannon::cannons.begin(), Cannon::cannons.end(), cannon));
-    field->erasePawn(cannon.get());
-}
-void Cannon::removeCannon(Cannon* cannon) {
-    auto it = std::find_if(Cannon::cannons.begin(), Cannon::cannons.end(),
-        [cannon](const std::shared_ptr<Cannon>& c) { return c.get() == cannon; });
-    if (it != Cannon::cannons.end()) {
-        field->erasePawn(cannon);
-        Cannon::cannons.erase(it);
-    }
-}
-Cannon::Cannon(sista::Coordinates coordinates, unsigned short period) : Entity('C', coordinates, cannonStyle, Type::CANNON) {}
-Cannon::Cannon() : Entity('C', {0, 0}, cannonStyle, Type::CANNON) {}
-void Cannon::fire() {
-    sista::Coordinates spawn = coordinates + directionMap[Direction::RIGHT];
-    if (!field->isFree(spawn)) {
-        return; // No complications, if you can't spawn something there just pretend the command was never given
-    }
-    if (Player::player->ammonitions <= 0) {
-        return; // No complications, if you can't spawn something there just pretend the command was never given
-    }
-    Player::player->ammonitions--;
-    std::shared_ptr<Bullet> newbullet = std::make_shared<Bullet>(spawn, Direction::RIGHT);
-    Bullet::bullets.push_back(newbullet);
-    field->addPrintPawn(newbullet);
-}
-void Cannon::recomputeDistribution(std::vector<std::vector<unsigned short>>& workersPositions) {
-    // Count the consecutive workers in the same row right back to the cannon
-    unsigned short count = 0;
-    for (unsigned short i=coordinates.x-1; i>=0; i--) {
-        if (std::find(workersPositions[coordinates.y].begin(), workersPositions[coordinates.y].end(), i) != workersPositions[coordinates.y].end()) {
-            count++;
-        } else {
-            break; // If there's no worker in the position, then there's no need to keep counting
-        }
-    }
-    distribution = std::bernoulli_distribution(1.0/((float)CANNON_FIRE_PERIOD - std::min(1.4*count, 39.0)));
-}
-
-sista::ANSISettings Worker::workerStyle = {
-    sista::ForegroundColor::YELLOW,
-    sista::BackgroundColor::BLACK,
-    sista::Attribute::UNDERSCORE
-};
-void Worker::removeWorker(std::shared_ptr<Worker> worker) {
-    Worker::workers.erase(std::find(Worker::workers.begin(), Worker::workers.end(), worker));
-    field->erasePawn(worker.get());
-}
-void Worker::removeWorker(Worker* worker) {
-    auto it = std::find_if(Worker::workers.begin(), Worker::workers.end(),
-        [worker](const std::shared_ptr<Worker>& other) { return other.get() == worker; });
-    if (it != Worker::workers.end()) {
-        Worker::workers.erase(it);
-        field->erasePawn(worker);
-    }
-}
-Worker::Worker(sista::Coordinates coordinates, unsigned short productionRate) : Entity('W', coordinates, workerStyle, Type::WORKER), distribution(std::bernoulli_distribution(1.0/productionRate)) {}
-Worker::Worker(sista::Coordinates coordinates) : Entity('W', coordinates, workerStyle, Type::WORKER), distribution(std::bernoulli_distribution(1.0/WORKER_PRODUCTION_PERIOD)) {}
-Worker::Worker() : Entity('W', {0, 0}, workerStyle, Type::WORKER), distribution(std::bernoulli_distribution(1.0/WORKER_PRODUCTION_PERIOD)) {}
-void Worker::produce() {
-    Player::player->ammonitions++;
-}
-
-sista::ANSISettings ArmedWorker::armedWorkerStyle = {
-    sista::ForegroundColor::YELLOW,
-    sista::BackgroundColor::BLUE,
-    sista::Attribute::UNDERSCORE
-};
-void ArmedWorker::removeArmedWorker(std::shared_ptr<ArmedWorker> worker) {
-    ArmedWorker::armedWorkers.erase(std::find(ArmedWorker::armedWorkers.begin(), ArmedWorker::armedWorkers.end(), worker));
-    field->erasePawn(worker.get());
-}
-void ArmedWorker::removeArmedWorker(ArmedWorker* worker) {
-    auto it = std::find_if(ArmedWorker::armedWorkers.begin(), ArmedWorker::armedWorkers.end(),
-        [worker](const std::shared_ptr<ArmedWorker>& other) { return other.get() == worker; });
-    if (it != ArmedWorker::armedWorkers.end()) {
-        ArmedWorker::armedWorkers.erase(it);
-        field->erasePawn(worker);
-    }
-}
-ArmedWorker::ArmedWorker(sista::Coordinates coordinates, unsigned short productionRate) : Entity('W', coordinates, armedWorkerStyle, Type::ARMED_WORKER), distribution(std::bernoulli_distribution(1.0/productionRate)) {}
-ArmedWorker::ArmedWorker(sista::Coordinates coordinates) : Entity('W', coordinates, armedWorkerStyle, Type::ARMED_WORKER), distribution(std::bernoulli_distribution(1.0/WORKER_PRODUCTION_PERIOD)) {}
-ArmedWorker::ArmedWorker() : Entity('W', {0, 0}, armedWorkerStyle, Type::ARMED_WORKER), distribution(std::bernoulli_distribution(1.0/WORKER_PRODUCTION_PERIOD)) {}
-void ArmedWorker::produce() {
-    Player::player->ammonitions++;
-}
-void ArmedWorker::dodgeIfNeeded() {
-    sista::Coordinates target = this->coordinates + directionMap[Direction::RIGHT] * 3;
-    if (field->isOutOfBounds(target))
-        return;
-    if (field->isOccupied(target)) {
-        if (((Entity*)field->getPawn(target))->type == Type::ENEMYBULLET) {
-            sista::Coordinates right = this->coordinates + directionMap[Direction::RIGHT];
-            if (field->isFree(right)) {
-                std::shared_ptr<Wall> newwall = std::make_shared<Wall>(right, 2);
-                Wall::walls.push_back(newwall);
-                field->addPrintPawn(newwall);
-            } else {
-                // If we can't place the wall, just give that up
-            }
-
-            sista::Coordinates destination = this->coordinates + directionMap[Direction::UP];
-            Direction moved = Direction::UP;
-            if (field->isFree(destination)) {
-                field->movePawn(this, destination);
-                std::cout << std::flush;
-            } else {
-                destination = this->coordinates + directionMap[Direction::DOWN];
-                moved = Direction::DOWN;
-                if (field->isFree(destination)) {
-                    field->movePawn(this, destination);
-                    std::cout << std::flush;
-                } else {
-                    return;
-                }
-            }
-            
-            std::shared_ptr<Bullet> newbullet = std::make_shared<Bullet>(
-                this->coordinates + directionMap[Direction::RIGHT], Direction::RIGHT
-            );
-            Bullet::bullets.push_back(newbullet);
-            field->addPrintPawn(newbullet);
-
-            destination = this->coordinates + directionMap[moved == Direction::UP ? Direction::DOWN : Direction::UP];
-            if (field->isFree(destination)) {
-                field->movePawn(this, destination);
-            }
-        }
-    }
-}
-
-sista::ANSISettings Bomber::bomberStyle = {
-    sista::ForegroundColor::BLUE,
-    sista::BackgroundColor::BLACK,
-    sista::Attribute::BRIGHT
-};
-void Bomber::removeBomber(std::shared_ptr<Bomber> bomber) {
-    Bomber::bombers.erase(std::find(Bomber::bombers.begin(), Bomber::bombers.end(), bomber));
-    field->erasePawn(bomber.get());
-}
-void Bomber::removeBomber(Bomber* bomber) {
-    auto it = std::find_if(Bomber::bombers.begin(), Bomber::bombers.end(),
-        [bomber](const std::shared_ptr<Bomber>& b) { return b.get() == bomber; });
-    if (it != Bomber::bombers.end()) {
-        Bomber::bombers.erase(it);
-        field->erasePawn(bomber);
-    }
-}
-Bomber::Bomber(sista::Coordinates coordinates) : Entity('B', coordinates, bomberStyle, Type::BOMBER) {}
-Bomber::Bomber() : Entity('B', {0, 0}, bomberStyle, Type::BOMBER) {}
-void Bomber::move() {
-    sista::Coordinates nextCoordinates = coordinates + directionMap[Direction::RIGHT];
-    if (field->isOutOfBounds(nextCoordinates)) {
-        if (coordinates.x == 49) {
-            this->explode();
-        }
-        this->exploded = true; // Mark for removal
-        return;
-    }
-    Entity* neighbor = (Entity*)field->getPawn(nextCoordinates);
-    if (neighbor == nullptr) {
-        field->movePawn((Pawn*)this, nextCoordinates);
-        coordinates = nextCoordinates;
-        return;
-    } else if (neighbor->type == Type::WALL) {
-        Wall* wall = (Wall*)neighbor;
-        wall->strength = 0;
-        wall->setSymbol('@'); // Change the symbol to '@' to indicate that the wall was destroyed
-        field->rePrintPawn(wall); // It will be reprinted in the next frame and then removed because of (strength == 0)
-        explode();
-    } else if (neighbor->type == Type::PLAYER) {
-        return; // The player keeps the bomber in place
-    } else if (neighbor->type == Type::BULLET) {
-        ((Bullet*)neighbor)->collided = true;
-    } else if (neighbor->type == Type::ENEMYBULLET) {
-        ((EnemyBullet*)neighbor)->collided = true;
-    } else if (neighbor->type == Type::MINE) {
-        Mine* mine = (Mine*)neighbor;
-        mine->triggered = true;
-    } else if (neighbor->type == Type::WALKER || neighbor->type == Type::ZOMBIE) {
-        explode();
-    } else if (neighbor->type == Type::QUEEN) {
-        Queen* mother = (Queen*)neighbor;
-        mother->life--;
-        field->rePrintPawn(mother);
-        mother->createWall();
-        if (mother->life == 0) {
-            // win();
-            end = true;
-        }
-    } else if (neighbor->type == Type::BOMBER) {
-        return;
-    }
-    this->exploded = true; // Mark for removal
-}
-void Bomber::explode() {
-    for (int j=-2; j<=2; j++) {
-        for (int i=-2; i<=2; i++) {
-            if (i == 0 && j == 0) continue;
-            sista::Coordinates nextCoordinates = coordinates + sista::Coordinates(j, i);
-            if (field->isOutOfBounds(nextCoordinates)) {
-                continue;
-            }
-            Entity* neighbor = (Entity*)field->getPawn(nextCoordinates);
-            if (neighbor == nullptr) {
-                continue;
-            } else if (neighbor->type == Type::ZOMBIE) {
-                Zombie::removeZombie((Zombie*)neighbor);
-            } else if (neighbor->type == Type::WALKER) {
-                Walker::removeWalker((Walker*)neighbor);
-            } else if (neighbor->type == Type::MINE) {
-                Mine* mine = (Mine*)neighbor;
-                mine->triggered = true;
-            } else if (neighbor->type == Type::CANNON) {
-                Cannon::removeCannon((Cannon*)neighbor);
-            } else if (neighbor->type == Type::QUEEN) {
-                Queen* mother = (Queen*)neighbor;
-                mother->life--;
-                field->rePrintPawn(mother);
-                mother->createWall();
-                if (mother->life == 0) {
-                    // win();
-                    end = true;
-                }
-            } else if (neighbor->type == Type::WALL) {
-                Wall* wall = (Wall*)neighbor;
-                int damage = rand() % 3 + 1;
-                if (wall->strength <= damage) {
-                    wall->strength = 0;
-                    wall->setSymbol('@'); // Change the symbol to '@' to indicate that the wall was destroyed
-                    field->rePrintPawn(wall); // It will be reprinted in the next frame and then removed because of (strength == 0)
-                } else {
-                    wall->strength -= damage;
-                }
-            } else if (neighbor->type == Type::BOMBER) {
-                continue;
-            }
-        }
-    }
-}
-
-sista::ANSISettings Walker::walkerStyle = {
-    sista::ForegroundColor::BLACK,
-    sista::BackgroundColor::GREEN,
-    sista::Attribute::BRIGHT
-};
-void Walker::removeWalker(std::shared_ptr<Walker> walker) {
-    Walker::walkers.erase(std::find(Walker::walkers.begin(), Walker::walkers.end(), walker));
-    field->erasePawn(walker.get());
-}
-void Walker::removeWalker(Walker* walker) {
-    auto it = std::find_if(Walker::walkers.begin(), Walker::walkers.end(),
-        [walker](const std::shared_ptr<Walker>& w) { return w.get() == walker; });
-    if (it != Walker::walkers.end()) {
-        Walker::walkers.erase(it);
-    }
-    field->erasePawn(walker);
-}
-Walker::Walker(sista::Coordinates coordinates) : Entity('Z', coordinates, walkerStyle, Type::WALKER) {}
-Walker::Walker() : Entity('Z', {0, 0}, walkerStyle, Type::WALKER) {}
-void Walker::move() { // Walkers mostly move horizontally because they only rarely shoot bullets and they walk slowly towards the left side
-    Direction direction_ = (rand() % 30 ? Direction::LEFT : Direction::DOWN);
-    sista::Coordinates nextCoordinates = coordinates + directionMap[direction_];
-    if (field->isOutOfBounds(nextCoordinates)) {
-        if (coordinates.x == 0) { // Touchdown, the player loses all the ammonitions
-            Player::player->ammonitions = 0;
-            this->explode();
-            this->exploded = true; // Mark for removal
-            return;
-        } else { // Touched bottom limit, we can use pacman effect which clearly can be used by walkers
-            try {
-                field->movePawnBy(this, directionMap[Direction::DOWN], sista::Effect::PACMAN);
-            } catch (const std::exception& e) {
-                // Nothing happens, but trying to apply manually the pacman effect and hitting something on the other side would be awkward
-            }
-            return;
-        }
-    }
-    Entity* neighbor = (Entity*)field->getPawn(nextCoordinates);
-    if (neighbor == nullptr) {
-        field->movePawn((Pawn*)this, nextCoordinates);
-        coordinates = nextCoordinates;
-        return;
-    } else if (neighbor->type == Type::PLAYER) {
-        // lose();
-        end = true;
-    } else if (neighbor->type == Type::BULLET) {
-        Bullet::removeBullet((Bullet*)neighbor);
-        this->exploded = true; // Mark for removal
-    } else if (neighbor->type == Type::WALL) {
-        Wall* wall = (Wall*)neighbor;
-        if (wall->strength == 0) {
-            return;
-        }
-        wall->strength--;
-        if (wall->strength == 0) {
-            wall->setSymbol('@'); // Change the symbol to '@' to indicate that the wall was destroyed
-            field->rePrintPawn(wall); // It will be reprinted in the next frame and then removed because of (strength == 0)
-        }
-    } else if (neighbor->type == Type::MINE) {
-        Mine* mine = (Mine*)neighbor;
-        mine->triggered = true;
-    } else if (neighbor->type == Type::CANNON) {
-        Cannon::removeCannon((Cannon*)neighbor);
-    } else if (neighbor->type == Type::WORKER) {
-        Worker::removeWorker((Worker*)neighbor);
-    } else if (neighbor->type == Type::ARMED_WORKER) {
-        ArmedWorker::removeArmedWorker((ArmedWorker*)neighbor);
-    }
-}
-void Walker::explode() {
-    for (int j=-1; j<=1; j++) {
-        for (int i=-1; i<=1; i++) {
-            if (i == 0 && j == 0) continue;
-            sista::Coordinates nextCoordinates = coordinates + sista::Coordinates(j, i);
-            if (field->isOutOfBounds(nextCoordinates)) {
-                continue;
-            }
-            Entity* neighbor = (Entity*)field->getPawn(nextCoordinates);
-            if (neighbor == nullptr) {
-                continue;
-            } else if (neighbor->type == Type::ZOMBIE) {
-                Zombie::removeZombie((Zombie*)neighbor);
-            } else if (neighbor->type == Type::WALKER) {
-                Walker::removeWalker((Walker*)neighbor);
-            } else if (neighbor->type == Type::ENEMYBULLET) {
-                EnemyBullet::removeEnemyBullet((EnemyBullet*)neighbor);
-            } else if (neighbor->type == Type::MINE) {
-                Mine* mine = (Mine*)neighbor;
-                mine->triggered = true;
-            } else if (neighbor->type == Type::CANNON) {
-                Cannon::removeCannon((Cannon*)neighbor);
-            } else if (neighbor->type == Type::WALL) {
-                Wall* wall = (Wall*)neighbor;
-                int damage = rand() % 3 + 1;
-                if (wall->strength <= damage) {
-                    wall->strength = 0;
-                    wall->setSymbol('@'); // Change the symbol to '@' to indicate that the wall was destroyed
-                    field->rePrintPawn(wall); // It will be reprinted in the next frame and then removed because of (strength == 0)
-                } else {
-                    wall->strength -= damage;
-                }
-            } else if (neighbor->type == Type::WORKER) {
-                Worker::removeWorker((Worker*)neighbor);
-            } else if (neighbor->type == Type::ARMED_WORKER) {
-                ArmedWorker::removeArmedWorker((ArmedWorker*)neighbor);
-            }
-        }
-    }
-}
-
-void removeNullptrs(std::vector<std::shared_ptr<Entity>>& entities) {
-    #if DEBUG
-    unsigned before = entities.size();
-    debug << "Before removing nullptrs: " << before << "\n";
-    #endif
-    entities.erase(
-        std::remove(entities.begin(), entities.end(), nullptr),
-        entities.end()
-    );
-    #if DEBUG
-    unsigned after = entities.size();
-    debug << "After removing nullptrs: " << after << "\n";
-    debug << "Removed " << before - after << " nullptrs\n";
-    #endif
-}
@@ -1,7 +1,16 @@
+#pragma once
 #include <sista/sista.hpp>
 #include <unordered_map>
 #include <vector>
 #include <random>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <streambuf>
+#include "pool.hpp"
+#include "arena.hpp"
+#include "jobs.hpp"
+#include "trace.hpp"
 
 
 #define CANNON_FIRE_PROBABILITY 0.025
@@ -11,16 +20,20 @@
 #define ZOMBIE_MOVING_PROBABILITY 0.2
 #define ZOMBIE_SHOOTING_PROBABILITY 0.01
 #define WALKER_MOVING_PROBABILITY 0.1
+#define WALKER_PATHFINDING_CELLS 4096 // Boards with at least this many cells route walkers with the flow field
 
 #define START_AMMONITION 10
+#define PROJECTILE_SPEED 1 // Cells per frame of every bullet, the paths are swept so any speed gives the same collisions
 
 #define HEIGHT 20
 #define WIDTH 50
+// Walkers follow the flow field around what's in their way, 0 for the blind walk to the left the game is balanced for
+#define WALKER_PATHFINDING (HEIGHT * WIDTH >= WALKER_PATHFINDING_CELLS)
 
 #define DEBUG 0
 #define INTRO 1
 #define TUTORIAL 1
-#define SCAN_FOR_NULLPTRS 0
+#define INTEGRITY_CHECK_PERIOD 100 // Frames between two checks of the field against the entity lists, 0 disables them
 #define VERSION "1.0.0-alpha.7"
 #define DATE "2025-12-16"
 
@@ -29,17 +42,25 @@
         #define START_AMMONITION 500
     #undef INTRO
         #define INTRO 0
-    #undef SCAN_FOR_NULLPTRS
-        #define SCAN_FOR_NULLPTRS 1
+    #undef INTEGRITY_CHECK_PERIOD
+        #define INTEGRITY_CHECK_PERIOD 1
 #endif
 
+#define INTEGRITY_REPORTED 4 // Mismatches described in an IntegrityReport, the others are only counted
+
+#define SNAPSHOT_FILE "dodas.sav" // Default path used by the 'v' key and by --load without an argument
+
+#define LANES_NO_IMPACT ((unsigned)-1) // Returned by ProjectileLanes::framesToImpact when nothing is coming
+#define ARMED_WORKER_REACTION 3 // Armed workers react to enemy bullets that are this many frames away, or closer
+#define CANNON_REACTION 2 // Cannons fire at once against enemy bullets that are this many frames away, or closer
+
 #define WIN_API_MUSIC_DELAY 80
 #define REPOPULATE 127 // The number of frame before the whole sista::Field is emptied and repopulated
 
 void printIntro();
 void tutorial();
 
-enum Type {
+enum Type : uint8_t {
     PLAYER,
     WORKER,
     ARMED_WORKER,
@@ -56,34 +77,427 @@ enum Type {
 };
 
 
-enum Direction {UP, RIGHT, DOWN, LEFT};
-extern std::unordered_map<Direction, sista::Coordinates> directionMap;
-extern std::unordered_map<Direction, char> directionSymbol;
-extern std::mt19937 rng;
+extern const char* typeNames[Type::QUEEN + 1]; // Lowercase names, for reports and metrics
+
+enum Direction : uint8_t {UP, RIGHT, DOWN, LEFT};
+struct DirectionTraits {
+    int8_t dy, dx;
+    Direction opposite;
+};
+constexpr DirectionTraits directionTraits[4] = {
+    {-1, 0, Direction::DOWN}, // UP
+    {0, 1, Direction::LEFT}, // RIGHT
+    {1, 0, Direction::UP}, // DOWN
+    {0, -1, Direction::RIGHT} // LEFT
+};
+// The step of one cell in that direction, negative steps wrap around as sista::Coordinates are unsigned
+inline sista::Coordinates directionOffset(Direction direction) {
+    return sista::Coordinates((unsigned short)directionTraits[direction].dy, (unsigned short)directionTraits[direction].dx);
+}
+
+// Every look an entity can have, as an index in styles. Looks that depend on the state of an entity (the direction of
+// a bullet, a destroyed wall, a triggered mine, the life of the queen) are consecutive ids added to the first one.
+enum StyleId : uint8_t {
+    PLAYER_STYLE,
+    WORKER_STYLE,
+    ARMED_WORKER_STYLE,
+    CANNON_STYLE,
+    BOMBER_STYLE,
+    BULLET_STYLE, // + Direction
+    ENEMYBULLET_STYLE = BULLET_STYLE + 4, // + Direction
+    WALL_STYLE = ENEMYBULLET_STYLE + 4,
+    DESTROYED_WALL_STYLE,
+    MINE_STYLE,
+    TRIGGERED_MINE_STYLE,
+    ZOMBIE_STYLE,
+    WALKER_STYLE,
+    QUEEN_STYLE, // + life, from 0 to 9
+    STYLES = QUEEN_STYLE + 10
+};
+struct Style {
+    char symbol;
+    sista::ANSISettings settings;
+};
+extern Style styles[STYLES]; // Shared by all the entities, an entity only keeps its StyleId
+
+enum CollisionClass : uint8_t {
+    SOLID, // Everything that isn't a projectile nor part of the horde
+    PROJECTILE, // Moves every frame and is indexed by the lanes
+    HORDE // Zombies and walkers: they trigger mines and bombers, enemy bullets don't hurt them
+};
+// What the code needs to know about an entity type without asking the entity, indexed by Type
+struct TypeTraits {
+    StyleId style; // The look it spawns with
+    uint8_t cost; // Ammonitions the player spends to place one, 0 if it can't be placed
+    uint8_t strength; // Hits a wall placed by the player or by an armed worker takes, 0 for the other types
+    uint8_t blastRadius; // Cells its explosion reaches in every direction, 0 if it doesn't explode
+    CollisionClass collision;
+};
+constexpr TypeTraits typeTraits[Type::QUEEN + 1] = {
+    {PLAYER_STYLE, 0, 0, 0, SOLID}, // PLAYER
+    {WORKER_STYLE, 5, 0, 0, SOLID}, // WORKER
+    {ARMED_WORKER_STYLE, 8, 0, 0, SOLID}, // ARMED_WORKER
+    {CANNON_STYLE, 5, 0, 0, SOLID}, // CANNON
+    {BOMBER_STYLE, 7, 0, 2, SOLID}, // BOMBER
+    {BULLET_STYLE, 1, 0, 0, PROJECTILE}, // BULLET, + Direction for the style
+    {MINE_STYLE, 3, 0, 2, SOLID}, // MINE
+    {WALL_STYLE, 1, 2, 0, SOLID}, // WALL
+    {ZOMBIE_STYLE, 0, 0, 0, HORDE}, // ZOMBIE
+    {WALKER_STYLE, 0, 0, 1, HORDE}, // WALKER
+    {ENEMYBULLET_STYLE, 0, 0, 0, PROJECTILE}, // ENEMYBULLET, + Direction for the style
+    {QUEEN_STYLE, 0, 0, 0, SOLID} // QUEEN, + life for the style
+};
 
+// Runtime copy of the balance constants, initialized from the macros above, so that tools can tune them without recompiling
+struct Balance {
+    unsigned short cannonFirePeriod = CANNON_FIRE_PERIOD;
+    unsigned short workerProductionPeriod = WORKER_PRODUCTION_PERIOD;
+    double zombieMovingProbability = ZOMBIE_MOVING_PROBABILITY;
+    double zombieShootingProbability = ZOMBIE_SHOOTING_PROBABILITY;
+    double walkerMovingProbability = WALKER_MOVING_PROBABILITY;
+    int startAmmonition = START_AMMONITION;
+    unsigned short projectileSpeed = PROJECTILE_SPEED;
+    bool walkerPathfinding = WALKER_PATHFINDING;
+};
 
+class GameWorld;
+class Entity;
+class Bullet;
+class EnemyBullet;
+class Player;
+class Zombie;
+class Queen;
+class Wall;
+class Mine;
+class Cannon;
+class Worker;
+class Bomber;
+class Walker;
+class ArmedWorker;
+
+// Every entity is allocated with its control block from the pool of its type, so spawning in a busy frame doesn't touch the heap
+template <typename T, typename... Args>
+std::shared_ptr<T> makeEntity(Args&&... args) {
+    return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+}
+
+// Bullets and enemy bullets indexed by the row (horizontal movers) or column (vertical movers) they travel along,
+// sorted by position, so that threat queries don't scan the field. It must be told about every spawn, step and removal.
+class ProjectileLanes {
+public:
+    void insert(Entity*);
+    void erase(Entity*);
+    void move(Entity*, sista::Coordinates); // Called before the coordinates of the projectile are updated
+    void clear();
+    // Frames until the nearest projectile of that type (BULLET or ENEMYBULLET) heading towards the cell enters it, ignoring obstacles
+    unsigned framesToImpact(sista::Coordinates, Type) const;
+
+private:
+    typedef std::set<std::pair<unsigned short, Entity*>, std::less<std::pair<unsigned short, Entity*>>, PoolAllocator<std::pair<unsigned short, Entity*>>> Lane; // Pooled nodes, moving a projectile doesn't touch the heap
+    Lane rows[HEIGHT][2][2]; // rows[y][enemy][moving left]
+    Lane columns[WIDTH][2][2]; // columns[x][enemy][moving up]
+    unsigned short maxSpeed = 1; // Upper bound of the speeds ever inserted, to stop the queries early
+
+    Lane& laneOf(Entity*, sista::Coordinates);
+};
+
+// What a projectile wants to do in a step of GameWorld::moveProjectiles, proposed before anything moves
+struct MoveIntent {
+    Entity* projectile;
+    sista::Coordinates from;
+    sista::Coordinates to;
+    enum State : uint8_t {PENDING, DONE} state;
+};
+
+#define FLOW_MAX_COST 8 // Upper bound of the moves a walker spends to enter a cell, the walls are capped to it
+#define FLOW_UNREACHABLE 0xFFFF
+
+// Moves a walker needs from every cell to the left edge of the field, counting the ones spent breaking through walls
+// and buildings, for all the walkers at once. It stores the direction of the first step of each cell, so a walker only
+// reads its own cell. Zombies and the other moving entities are ignored as they don't stay in the way, so the field
+// is only recomputed, in O(cells) whatever the number of walkers, when a wall, a mine or a building changes.
+class FlowField {
+public:
+    FlowField();
+
+    void update(const GameWorld&);
+    Direction next(sista::Coordinates coordinates) const { return directions[coordinates.y * WIDTH + coordinates.x]; }
+    unsigned short distance(sista::Coordinates coordinates) const { return distances[coordinates.y * WIDTH + coordinates.x]; }
+
+private:
+    std::vector<unsigned short> distances; // [y*WIDTH + x], FLOW_UNREACHABLE if the left edge can't be reached
+    std::vector<Direction> directions; // [y*WIDTH + x], LEFT for the unreachable cells
+    std::vector<uint8_t> costs; // [y*WIDTH + x] moves to enter the cell, 0 if impassable, as of the last computation
+    std::vector<uint8_t> nextCosts; // Scratch buffer of update, kept to avoid allocations
+    std::vector<unsigned short> buckets[FLOW_MAX_COST + 1]; // Cells by distance % (FLOW_MAX_COST + 1), kept to avoid allocations
+};
+
+// A disagreement between the field and the entity lists found by GameWorld::checkIntegrity
+struct IntegrityMismatch {
+    enum Kind : uint8_t {
+        UNLISTED, // On the field but in no list, it still blocks and can be hit
+        MISSING, // In a list but not on the field (or somewhere else)
+        DUPLICATE // In the lists more than once
+    };
+    Kind kind;
+    Type type;
+    sista::Coordinates coordinates;
+};
+struct IntegrityReport {
+    unsigned entities = 0; // Listed entities that were checked
+    unsigned mismatches = 0;
+    IntegrityMismatch first[INTEGRITY_REPORTED]; // The first min(mismatches, INTEGRITY_REPORTED) mismatches
+};
+
+// What happened in the simulation, for whoever shows it (renderer, HUD, audio, metrics): the simulation only emits
+// events into GameWorld::events and never prints nor plays anything because of them
+enum GameEventKind : uint8_t {
+    QUEEN_DAMAGED, // value: life left to the queen
+    WALL_DESTROYED, // The wall stays on the field, destroyed, until the end of the frame
+    ENTITY_SPAWNED,
+    ENTITY_KILLED, // Removed from its list and from the field, for any reason
+    AMMO_CHANGED, // value: ammonitions of the player
+    AMMO_EMPTY, // The player tried to place something without ammonitions
+    GAME_ENDED, // value: 1 if the queen died, 0 if the player did
+    GAME_EVENT_KINDS
+};
+struct GameEvent {
+    GameEventKind kind;
+    Type type; // Of the entity the event is about
+    sista::Coordinates coordinates; // Where it happened, the entity itself may be gone when the event is consumed
+    int value;
+};
+extern const char* gameEventNames[GAME_EVENT_KINDS]; // Lowercase names, for reports and metrics
+
+// An entity a game starts with
+struct Placement {
+    Type type;
+    sista::Coordinates coordinates;
+    short strength = 0; // Walls only
+};
+// Enemies the queen sends from the right edge, each in a random row other than her own, in the frames where
+// i % period == phase. A wave finding its cell taken skips the rest of the frame, hordes are placed whatever is in
+// the cell, as they always were.
+struct Wave {
+    Type type; // ZOMBIE or WALKER
+    unsigned period;
+    unsigned phase;
+    unsigned short count = 1; // Enemies in every spawn
+    unsigned growth = 0; // Plus one enemy every growth frames since the start, 0 for a fixed count
+    bool hardcore = false; // Only in hardcore mode
+
+    bool horde() const { return count != 1 || growth != 0; }
+};
+// Initial layout and spawn timeline of a game, read from a file by loadScenario (scenario.hpp)
+struct Scenario {
+    std::vector<Placement> placements; // In the order they are added to the lists
+    std::vector<Wave> waves; // In the order they spawn in a frame
+};
+Scenario defaultScenario(); // The macrowall layout and the waves the game always had
+
+// splitmix64 finalizer, spreads consecutive values over the 64 bits
+inline uint64_t mix64(uint64_t value) {
+    value = (value + 1) * 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+// Key of an entity with that look in cell y*WIDTH + x, computed instead of drawn from a table of random numbers,
+// so that every build and every platform agrees on the hash of the same field
+inline uint64_t zobristKey(unsigned cell, StyleId style) {
+    return mix64((uint64_t)cell * STYLES + style);
+}
+
+// The field with a Zobrist hash of what's on it: the XOR of zobristKey(cell, style) of every pawn, kept up to date by
+// every change of the field in O(1), so that two games can be compared frame by frame without scanning them.
+// Sista has no hook for changes, so the methods that change the field hide the ones of sista::SwappableField and XOR
+// the cells they touch out before and back in after, whatever the base method does with the pawn that was there.
+// Every pawn is an Entity, changing its look goes through Entity::setStyle.
+class HashedField : public sista::SwappableField {
+public:
+    uint64_t hash = 0;
+
+    HashedField(int width, int height) : sista::SwappableField(width, height) {}
+
+    void addPawn(std::shared_ptr<sista::Pawn>);
+    void addPrintPawn(std::shared_ptr<sista::Pawn>);
+    void erasePawn(sista::Pawn*);
+    void erasePawn(sista::Coordinates);
+    void movePawn(sista::Pawn*, sista::Coordinates);
+    void movePawnBy(sista::Pawn*, sista::Coordinates, sista::Effect);
+    void clear();
+
+    void toggle(sista::Coordinates); // XORs the key of the pawn in the cell, if there is one, into hash
+    uint64_t recompute(); // The hash computed from scratch by scanning every cell, to check the incremental one
+};
+
+// Everything a single game needs: many GameWorlds can live in the same process, each driven by one thread at a time
+class GameWorld {
+public:
+    std::unique_ptr<HashedField> field;
+    std::vector<std::shared_ptr<Bullet>> bullets;
+    std::vector<std::shared_ptr<EnemyBullet>> enemyBullets;
+    std::vector<std::shared_ptr<Zombie>> zombies;
+    std::vector<std::shared_ptr<Walker>> walkers;
+    std::vector<std::shared_ptr<Wall>> walls;
+    std::vector<std::shared_ptr<Mine>> mines;
+    std::vector<std::shared_ptr<Cannon>> cannons;
+    std::vector<std::shared_ptr<ArmedWorker>> armedWorkers;
+    std::vector<std::shared_ptr<Worker>> workers;
+    std::vector<std::shared_ptr<Bomber>> bombers;
+    std::shared_ptr<Player> player;
+    std::shared_ptr<Queen> queen;
+    ProjectileLanes lanes; // Index of bullets and enemyBullets
+    FlowField flowField; // Shared by the walkers, updated in every frame where they move
+    FrameArena arena; // Temporaries of the current frame, reset at the start of the next update()
+    JobSystem* jobs = nullptr; // Runs the phases of update() that only read the world, inline when nullptr. Not forked.
+    // Events emitted since the consumer last cleared the list, only recorded when recordEvents is set, so the hosts
+    // that don't look at them (balance, soak, libdodas) don't pay for them. The consumer clears the list once it read it.
+    std::vector<GameEvent> events;
+    bool recordEvents = false;
+
+    bool end = false; // Set when the queen or the player dies
+    bool paused = false;
+    std::mutex mutex; // Held by the frame loop and by the input thread while they change the world
+    std::mt19937 rng;
+    Balance balance;
+    Scenario scenario; // What populate() places and update() spawns, defaultScenario() unless replaced
+    std::bernoulli_distribution zombieDistribution; // The zombie moves a cell every zombieSpeed frames, on average
+    std::bernoulli_distribution zombieShootDistribution; // The zombie shoots a bullet every zombieShootingRate frames, on average
+    std::bernoulli_distribution walkerDistribution; // The walker moves a cell every walkerSpeed frames, on average
+    std::bernoulli_distribution workerDistribution; // Workers and armed workers produce an ammonition every workerProductionPeriod frames, on average
+
+    GameWorld(); // Seeded with the clock
+    GameWorld(unsigned);
+
+    int rand(); // Replaces ::rand(), whose state is shared by the whole process, drawing from rng
+    void applyBalance(); // Recomputes the distributions from balance
+    void clear(); // Empties every entity list and the field, so that populate() can start a new game
+    // Makes the other world an exact copy of this one, that plays on identically from the same inputs, for lookahead
+    // searches. The entities the other world already has are overwritten instead of freed, so forking over and over into
+    // the same world doesn't allocate and takes time proportional to the number of entities, not to the field.
+    // Pawns left on the field by entities that are in no list any more are copied too.
+    void fork(GameWorld&) const;
+    void populate(); // Places the initial entities of a new game, from the scenario
+    bool update(unsigned, bool); // Simulates frame i, returns false if the rest of the frame (rendering) must be skipped
+    bool spawnWaves(unsigned, bool); // Spawns the waves of the scenario due in frame i, false if one found its cell taken
+    // Moves every bullet and enemy bullet in two phases: all of them propose their next cell, then the moves are committed,
+    // destroying projectiles that enter the same cell or cross each other head-on, so the order of the lists doesn't matter
+    void moveProjectiles();
+    void removeCollidedProjectiles(); // Erases the collided projectiles from their list, the field and the lanes
+    // Checks that every listed entity is on the field at its coordinates and that every pawn of the field is listed,
+    // in O(entities + cells). Returns false if there was any mismatch. The world is left as it is, so that a game plays
+    // the same whether it is checked or not.
+    bool checkIntegrity(IntegrityReport&) const;
+    void emit(GameEventKind, Entity*, int value = 0); // Records an event about the entity, if events are recorded
+    void finish(bool won); // Ends the game, emitting GAME_ENDED, the queen died if won
+    uint64_t stateHash() const; // Hash of the field, the ammonitions of the player and the life of the queen
+    std::size_t entityCount(Type) const; // Entities of that type in their list (0 or 1 for the player and the queen)
+    std::size_t entityCount() const; // Entities of every type, the sum of the above
+
+    template <typename T> std::vector<std::shared_ptr<T>>& list(); // The list holding the entities of type T
+    // Creates a T at the coordinates with the other arguments of its constructor, adds it to its list (and to the lanes
+    // if it's a projectile) and prints it. The caller checks that the cell is free.
+    template <typename T, typename... Args> std::shared_ptr<T> spawn(sista::Coordinates, Args&&...);
+
+private:
+    std::vector<MoveIntent> intents; // Scratch buffers of moveProjectiles, kept to avoid allocations
+    std::vector<int> intentAt; // [y*WIDTH + x] index of the intent of the projectile in that cell, -1 if none
+    std::vector<int> claimedBy; // [y*WIDTH + x] index of the first intent entering that cell, -1 if none
+};
+
+
+// sista::Pawn keeps the symbol and the settings it prints with, they are refreshed from styles when the look changes
 class Entity : public sista::Pawn {
 public:
     Type type;
+    StyleId style;
+    GameWorld* world;
 
     Entity();
-    Entity(char, sista::Coordinates, sista::ANSISettings&, Type);
+    Entity(GameWorld*, sista::Coordinates, StyleId, Type);
+
+    void setStyle(StyleId); // Changes the look (and the hash of the field), the caller reprints the pawn if it's on the field
 };
 
+inline void HashedField::toggle(sista::Coordinates coordinates) {
+    if (isOutOfBounds(coordinates))
+        return;
+    Entity* entity = (Entity*)getPawn(coordinates);
+    if (entity != nullptr)
+        hash ^= zobristKey(coordinates.y * WIDTH + coordinates.x, entity->style);
+}
+inline void HashedField::addPawn(std::shared_ptr<sista::Pawn> pawn) {
+    sista::Coordinates coordinates = pawn->getCoordinates();
+    toggle(coordinates);
+    sista::SwappableField::addPawn(pawn);
+    toggle(coordinates);
+}
+inline void HashedField::addPrintPawn(std::shared_ptr<sista::Pawn> pawn) {
+    sista::Coordinates coordinates = pawn->getCoordinates();
+    toggle(coordinates);
+    sista::SwappableField::addPrintPawn(pawn);
+    toggle(coordinates);
+}
+inline void HashedField::erasePawn(sista::Pawn* pawn) {
+    sista::Coordinates coordinates = pawn->getCoordinates();
+    toggle(coordinates);
+    sista::SwappableField::erasePawn(pawn);
+    toggle(coordinates);
+}
+inline void HashedField::erasePawn(sista::Coordinates coordinates) {
+    toggle(coordinates);
+    sista::SwappableField::erasePawn(coordinates);
+    toggle(coordinates);
+}
+inline void HashedField::movePawn(sista::Pawn* pawn, sista::Coordinates coordinates) {
+    sista::Coordinates from = pawn->getCoordinates();
+    bool moving = coordinates.y != from.y || coordinates.x != from.x;
+    toggle(from);
+    if (moving)
+        toggle(coordinates);
+    sista::SwappableField::movePawn(pawn, coordinates);
+    toggle(from);
+    if (moving)
+        toggle(coordinates);
+}
+// Only the cell of the pawn is toggled before the move: the base method throws instead of moving onto another pawn
+inline void HashedField::movePawnBy(sista::Pawn* pawn, sista::Coordinates offset, sista::Effect effect) {
+    sista::Coordinates from = pawn->getCoordinates();
+    toggle(from);
+    try {
+        sista::SwappableField::movePawnBy(pawn, offset, effect);
+    } catch (...) {
+        toggle(from);
+        throw;
+    }
+    sista::Coordinates to = pawn->getCoordinates();
+    toggle(from);
+    if (to.y != from.y || to.x != from.x)
+        toggle(to);
+}
+inline void HashedField::clear() {
+    sista::SwappableField::clear();
+    hash = 0;
+}
+
+inline void GameWorld::emit(GameEventKind kind, Entity* entity, int value) {
+    if (recordEvents)
+        events.push_back({kind, entity->type, entity->getCoordinates(), value});
+}
+
 
 class Bullet : public Entity {
 public:
-    static sista::ANSISettings bulletStyle;
-    static std::vector<std::shared_ptr<Bullet>> bullets;
     Direction direction;
     unsigned short speed = 1; // The bullet moves speed cells per frame
     bool collided = false; // If the bullet was destroyed in a collision with an opposite bullet
 
     Bullet();
-    Bullet(sista::Coordinates, Direction);
-    Bullet(sista::Coordinates, Direction, unsigned short);
+    Bullet(GameWorld*, sista::Coordinates, Direction);
+    Bullet(GameWorld*, sista::Coordinates, Direction, unsigned short);
 
-    void move();
+    void hit(Entity*); // Effects of running into something that isn't a projectile, the bullet is then destroyed
 
     static void removeBullet(std::shared_ptr<Bullet>);
     static void removeBullet(Bullet*); // Overload for raw pointer
@@ -92,17 +506,15 @@ public:
 
 class EnemyBullet : public Entity {
 public:
-    static sista::ANSISettings enemyBulletStyle;
-    static std::vector<std::shared_ptr<EnemyBullet>> enemyBullets;
     Direction direction;
     unsigned short speed = 1; // The bullet moves speed cells per frame
     bool collided = false; // If the bullet was destroyed in a collision with an opposite bullet
 
     EnemyBullet();
-    EnemyBullet(sista::Coordinates, Direction);
-    EnemyBullet(sista::Coordinates, Direction, unsigned short);
+    EnemyBullet(GameWorld*, sista::Coordinates, Direction);
+    EnemyBullet(GameWorld*, sista::Coordinates, Direction, unsigned short);
 
-    void move();
+    void hit(Entity*); // Effects of running into something that isn't a projectile, the bullet is then destroyed
 
     static void removeEnemyBullet(std::shared_ptr<EnemyBullet>);
     static void removeEnemyBullet(EnemyBullet*); // Overload for raw pointer
@@ -111,14 +523,12 @@ public:
 
 class Player : public Entity {
 public:
-    static sista::ANSISettings playerStyle;
-    static std::shared_ptr<Player> player;
     Type weapon = Type::BULLET; // The player can have different weapons (bullets, mines, etc.)
     int ammonitions; // The player has a certain amount of ammonition (when it reaches 0, the player can't shoot anymore)
     unsigned short speed = 1; // The player shoots bullets at speed cells per frame
 
     Player();
-    Player(sista::Coordinates);
+    Player(GameWorld*, sista::Coordinates);
 
     void move(Direction);
     void shoot(Direction);
@@ -127,13 +537,9 @@ public:
 
 class Zombie : public Entity {
 public:
-    static sista::ANSISettings zombieStyle;
-    static std::vector<std::shared_ptr<Zombie>> zombies;
-    static std::bernoulli_distribution distribution; // The zombie moves a cell every zombieSpeed frames, on average
-    static std::bernoulli_distribution shootDistribution; // The zombie shoots a bullet every zombieShootingRate frames, on average
 
     Zombie();
-    Zombie(sista::Coordinates);
+    Zombie(GameWorld*, sista::Coordinates);
 
     void move(); // They should move mostly vertically
     // void move(Direction);
@@ -147,26 +553,26 @@ public:
 
 class Queen : public Entity {
 public:
-    static sista::ANSISettings queenStyle;
-    static std::shared_ptr<Queen> queen;
     int life; // The mother has a life score (when it reaches 0, the game is over) which regenerates over time
 
     Queen();
-    Queen(sista::Coordinates);
+    Queen(GameWorld*, sista::Coordinates);
 
     void move(); // Only moves vertically in a small range, I want it to always be near the center
+    void showLife(); // Sets the look to the digit of its life
+    void damage(); // Takes one life, builds a wall in front of her and ends the game at 0
     void createWall(); // Creates a 1x[3-5] wall of strenght 1 in front of the queen
 };
 
 
 class Wall : public Entity {
 public:
-    static sista::ANSISettings wallStyle;
-    static std::vector<std::shared_ptr<Wall>> walls;
     short int strength; // The wall has a certain strength (when it reaches 0, the wall is destroyed)
 
     Wall();
-    Wall(sista::Coordinates, short int);
+    Wall(GameWorld*, sista::Coordinates, short int);
+
+    void destroy(); // Shows it destroyed, it is removed at the end of the frame because of (strength == 0)
 
     static void removeWall(std::shared_ptr<Wall>);
 };
@@ -174,15 +580,14 @@ public:
 
 class Mine : public Entity {
 public:
-    static sista::ANSISettings mineStyle;
-    static std::vector<std::shared_ptr<Mine>> mines;
-    bool triggered = false;
     bool alive = true;
 
     Mine();
-    Mine(sista::Coordinates);
+    Mine(GameWorld*, sista::Coordinates);
 
+    bool triggered() const { return style == TRIGGERED_MINE_STYLE; }
     bool checkTrigger();
+    bool hordeNearby() const; // Whether a neighbor cell holds a zombie or a walker, only reads the field
     void trigger();
     void explode();
 
@@ -192,15 +597,13 @@ public:
 
 class Cannon : public Entity { // Cannons shoot bullets only against the zombies, they have a certain firing rate
 public:
-    static sista::ANSISettings cannonStyle;
-    static std::vector<std::shared_ptr<Cannon>> cannons;
-    static std::bernoulli_distribution distribution; // The cannon shoots a bullet every firingRate frames, on average
+    std::bernoulli_distribution distribution; // The cannon shoots a bullet every firingRate frames, on average
 
     Cannon();
-    Cannon(sista::Coordinates, unsigned short);
+    Cannon(GameWorld*, sista::Coordinates, unsigned short);
 
     void fire();
-    void recomputeDistribution(std::vector<std::vector<unsigned short>>&);
+    void recomputeDistribution(const FrameVector<FrameVector<unsigned short>>&);
 
     static void removeCannon(std::shared_ptr<Cannon>);
     static void removeCannon(Cannon*); // Overload for raw pointer
@@ -209,13 +612,8 @@ public:
 
 class Worker : public Entity { // Workers produce ammonition for the player, they have a certain production rate
 public:
-    static sista::ANSISettings workerStyle;
-    static std::vector<std::shared_ptr<Worker>> workers;
-    std::bernoulli_distribution distribution; // The worker produces an ammonition every productionRate frames, on average
-
     Worker();
-    Worker(sista::Coordinates);
-    Worker(sista::Coordinates, unsigned short);
+    Worker(GameWorld*, sista::Coordinates);
 
     void produce();
 
@@ -226,12 +624,10 @@ public:
 
 class Bomber : public Entity { // Bombers go towards the enemies and explode when they meet a wall
 public:
-    static sista::ANSISettings bomberStyle;
-    static std::vector<std::shared_ptr<Bomber>> bombers;
     bool exploded = false;
 
     Bomber();
-    Bomber(sista::Coordinates);
+    Bomber(GameWorld*, sista::Coordinates);
 
     void move();
     void explode();
@@ -242,13 +638,10 @@ public:
 
 class Walker : public Entity { // Walkers go towards the left side of the screen and can kill the player on touch, and they explode as bombers when they meet a worker
 public:
-    static sista::ANSISettings walkerStyle;
-    static std::vector<std::shared_ptr<Walker>> walkers;
-    static std::bernoulli_distribution distribution; // The walker moves a cell every walkerSpeed frames, on average
     bool exploded = false;
 
     Walker();
-    Walker(sista::Coordinates);
+    Walker(GameWorld*, sista::Coordinates);
 
     void move();
     void explode();
@@ -259,13 +652,8 @@ public:
 
 class ArmedWorker : public Entity { // Workers produce ammonition for the player, they have a certain production rate
 public:
-    static sista::ANSISettings armedWorkerStyle;
-    static std::vector<std::shared_ptr<ArmedWorker>> armedWorkers;
-    std::bernoulli_distribution distribution; // The worker produces an ammonition every productionRate frames, on average
-
     ArmedWorker();
-    ArmedWorker(sista::Coordinates);
-    ArmedWorker(sista::Coordinates, unsigned short);
+    ArmedWorker(GameWorld*, sista::Coordinates);
 
     void produce();
     void dodgeIfNeeded();
@@ -274,4 +662,33 @@ public:
     static void removeArmedWorker(ArmedWorker*); // Overload for raw pointer
 };
 
+// Stream buffer that discards everything, hosts running worlds without a terminal install it in std::cout
+class NullBuffer : public std::streambuf {
+protected:
+    std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+    int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+};
+
 void removeNullptrs(std::vector<std::shared_ptr<Entity>>&);
+
+template <> inline std::vector<std::shared_ptr<Bullet>>& GameWorld::list<Bullet>() { return bullets; }
+template <> inline std::vector<std::shared_ptr<EnemyBullet>>& GameWorld::list<EnemyBullet>() { return enemyBullets; }
+template <> inline std::vector<std::shared_ptr<Zombie>>& GameWorld::list<Zombie>() { return zombies; }
+template <> inline std::vector<std::shared_ptr<Walker>>& GameWorld::list<Walker>() { return walkers; }
+template <> inline std::vector<std::shared_ptr<Wall>>& GameWorld::list<Wall>() { return walls; }
+template <> inline std::vector<std::shared_ptr<Mine>>& GameWorld::list<Mine>() { return mines; }
+template <> inline std::vector<std::shared_ptr<Cannon>>& GameWorld::list<Cannon>() { return cannons; }
+template <> inline std::vector<std::shared_ptr<ArmedWorker>>& GameWorld::list<ArmedWorker>() { return armedWorkers; }
+template <> inline std::vector<std::shared_ptr<Worker>>& GameWorld::list<Worker>() { return workers; }
+template <> inline std::vector<std::shared_ptr<Bomber>>& GameWorld::list<Bomber>() { return bombers; }
+
+template <typename T, typename... Args>
+std::shared_ptr<T> GameWorld::spawn(sista::Coordinates coordinates, Args&&... args) {
+    std::shared_ptr<T> entity = makeEntity<T>(this, coordinates, std::forward<Args>(args)...);
+    list<T>().push_back(entity);
+    if (typeTraits[entity->type].collision == PROJECTILE)
+        lanes.insert(entity.get());
+    field->addPrintPawn(entity);
+    emit(ENTITY_SPAWNED, entity.get());
+    return entity;
+}
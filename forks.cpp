@@ -0,0 +1,111 @@
+// Fork benchmark: forks a mid-game world into another world over and over, as a lookahead search would, and reports forks per second
+//
+//  ./forks [-p policy] [-f frames] [-n forks] [-l lookahead] [-s seed] [-c scenario] [-N]
+//
+// The bot plays -f frames in hardcore mode (-N for normal mode) to reach the forked state, starting a new game with the next
+// seed if one ends before. -l plays that many frames in the fork after each fork, with the actions of the bot, to also
+// measure a whole search step. Before measuring, a fork and the original play FORKS_CHECK frames side by side and must
+// stay identical.
+#include "bot.hpp"
+#include "scenario.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#define FORKS_FRAMES 1000 // Default number of frames played before forking
+#define FORKS_COUNT 1000000 // Default number of forks
+#define FORKS_CHECK 200 // Frames the fork and the original play side by side to check the fork
+
+int main(int argc, char** argv) {
+    std::string policyName = "heuristic";
+    unsigned frames = FORKS_FRAMES;
+    unsigned long long forks = FORKS_COUNT;
+    unsigned lookahead = 0;
+    unsigned seed = 1;
+    bool hardcore = true;
+    std::string scenarioPath;
+    for (int i=1; i<argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-p" && i + 1 < argc) {
+            policyName = argv[++i];
+        } else if (arg == "-f" && i + 1 < argc) {
+            frames = std::atoi(argv[++i]);
+        } else if (arg == "-n" && i + 1 < argc) {
+            forks = std::max(1LL, std::atoll(argv[++i]));
+        } else if (arg == "-l" && i + 1 < argc) {
+            lookahead = std::atoi(argv[++i]);
+        } else if (arg == "-s" && i + 1 < argc) {
+            seed = std::atoi(argv[++i]);
+        } else if (arg == "-c" && i + 1 < argc) {
+            scenarioPath = argv[++i];
+        } else if (arg == "-N") {
+            hardcore = false;
+        } else {
+            std::cerr << "Unknown argument " << arg << std::endl;
+            return 1;
+        }
+    }
+    std::unique_ptr<Policy> policy = makePolicy(policyName, seed);
+    if (policy == nullptr) {
+        std::cerr << "Unknown policy " << policyName << std::endl;
+        return 1;
+    }
+
+    NullBuffer nullBuffer;
+    std::ostream report(std::cout.rdbuf());
+    std::cout.rdbuf(&nullBuffer); // Sista prints every change of the field on std::cout
+    GameWorld world(seed);
+    std::string error;
+    if (!scenarioPath.empty() && !loadScenario(world.scenario, scenarioPath, error)) {
+        std::cerr << "Invalid scenario, " << error << std::endl;
+        return 1;
+    }
+    world.populate();
+    unsigned i = 0; // Frame of the current game
+    for (unsigned frame=0; frame<frames; frame++) {
+        applyAction(world, policy->decide(world));
+        world.update(i++, hardcore);
+        if (world.end) {
+            world.clear();
+            world.rng.seed(++seed);
+            world.populate();
+            i = 0;
+        }
+    }
+
+    GameWorld saved(seed), fork(seed);
+    world.fork(saved);
+    world.fork(fork);
+    for (unsigned j=0; j<FORKS_CHECK && !world.end; j++) {
+        BotAction action = policy->decide(world);
+        applyAction(world, action);
+        applyAction(fork, action);
+        world.update(i + j, hardcore);
+        fork.update(i + j, hardcore);
+        if (world.stateHash() != fork.stateHash() || fork.field->hash != fork.field->recompute()) {
+            std::cerr << "The fork diverged from the original " << j << " frames after the fork" << std::endl;
+            return 1;
+        }
+    }
+    saved.fork(world); // Back to the state after -f frames
+
+    unsigned long long lookaheadFrames = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long long j=0; j<forks; j++) {
+        world.fork(fork);
+        for (unsigned k=0; k<lookahead && !fork.end; k++) {
+            applyAction(fork, policy->decide(fork));
+            fork.update(i + k, hardcore);
+            lookaheadFrames++;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    report << "entities\tforks\tforks/s\tns/fork\tlookahead_frames" << std::endl;
+    report << world.entityCount() << '\t' << forks << '\t' << std::fixed << std::setprecision(0) << forks / seconds << '\t';
+    report << seconds * 1e9 / forks << '\t' << lookaheadFrames << std::endl;
+    return 0;
+}
@@ -0,0 +1,1564 @@
+#include "dodas.hpp"
+#include <algorithm>
+#include <bitset>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+std::atomic<unsigned long long> poolBlocks(0);
+
+GameWorld::GameWorld() : GameWorld(std::chrono::system_clock::now().time_since_epoch().count()) {}
+GameWorld::GameWorld(unsigned seed) : field(std::make_unique<HashedField>(WIDTH, HEIGHT)), rng(seed), scenario(defaultScenario()) {
+    applyBalance();
+}
+
+int GameWorld::rand() {
+    return rng() >> 1; // Same range as ::rand() with glibc, [0, 2^31)
+}
+
+void GameWorld::applyBalance() {
+    zombieDistribution = std::bernoulli_distribution(balance.zombieMovingProbability);
+    zombieShootDistribution = std::bernoulli_distribution(balance.zombieShootingProbability);
+    walkerDistribution = std::bernoulli_distribution(balance.walkerMovingProbability);
+    workerDistribution = std::bernoulli_distribution(1.0/balance.workerProductionPeriod);
+}
+
+bool GameWorld::update(unsigned i, bool hardcore) {
+    arena.reset(); // The previous frame is over, including what ran after its update() (rendering, checks)
+    traceFrame = i;
+    removeCollidedProjectiles();
+    moveProjectiles(); // Player and enemy bullets move at the same time, whatever their order in the lists
+    removeCollidedProjectiles();
+
+    // removeNullptrs((std::vector<std::shared_ptr<Entity>>&)enemyBullets);
+    // removeNullptrs((std::vector<std::shared_ptr<Entity>>&)zombies);
+    for (const std::shared_ptr<Zombie>& zombie : zombies) { // References, copying the shared_ptr would touch the reference count
+        if (zombieDistribution(rng))
+            zombie->move();
+    }
+    // removeNullptrs((std::vector<std::shared_ptr<Entity>>&)walkers);
+    for (const std::shared_ptr<Zombie>& zombie : zombies)
+        if (zombieShootDistribution(rng))
+            zombie->shoot();
+    // removeNullptrs((std::vector<std::shared_ptr<Entity>>&)walkers);
+    walkers.erase(
+        std::remove_if(
+            walkers.begin(),
+            walkers.end(),
+            [this](const std::shared_ptr<Walker>& walker) {
+                if (!walker) return true;
+                if (walker->exploded) {
+                    emit(ENTITY_KILLED, walker.get());
+                    // Remove pawn from field before erasing
+                    field->erasePawn(walker.get());
+                    return true;
+                }
+                return false;
+            }
+        ),
+        walkers.end()
+    );
+    bool flowComputed = false;
+    for (unsigned j=0; j<walkers.size(); j++) { // An exploding walker can remove the others from the list
+        std::shared_ptr<Walker> walker = walkers[j];
+        if (walker->exploded) continue;
+        if (walkerDistribution(rng)) {
+            if (balance.walkerPathfinding && !flowComputed) { // Only in the frames where a walker moves
+                flowField.update(*this);
+                flowComputed = true;
+            }
+            walker->move();
+        }
+    }
+    walkers.erase(
+        std::remove_if(
+            walkers.begin(),
+            walkers.end(),
+            [this](const std::shared_ptr<Walker>& walker) {
+                if (!walker) return true;
+                if (walker->exploded) {
+                    emit(ENTITY_KILLED, walker.get());
+                    // Remove pawn from field before erasing
+                    field->erasePawn(walker.get());
+                    return true;
+                }
+                return false;
+            }
+        ),
+        walkers.end()
+    );
+    // removeNullptrs((std::vector<std::shared_ptr<Entity>>&)workers);        
+    FrameVector<FrameVector<unsigned short>> workersPositions(HEIGHT, FrameVector<unsigned short>(arena), arena); // workersPositions[y] = {x1, x2, x3, ...} where the workers are
+    for (const std::shared_ptr<Worker>& worker : workers)
+        workersPositions[worker->getCoordinates().y].push_back(worker->getCoordinates().x);
+
+    // What only reads the world runs as jobs, spread over the threads of the JobSystem: which mines have the horde next
+    // to them, and the fire rate of each cannon and whether an enemy bullet is about to hit it. The results are stored
+    // at the index of the entity and applied in the order of the lists, with the draws from rng, so the frame is the
+    // same whatever the number of threads. The cannons can aim before the workers play: producing and dodging move
+    // no worker and add no enemy bullet.
+    FrameVector<uint8_t> hordeNearMines(mines.size(), 0, arena);
+    FrameVector<uint8_t> cannonsThreatened(cannons.size(), 0, arena);
+    auto checkMines = [&](std::size_t begin, std::size_t end) {
+        for (std::size_t j=begin; j<end; j++)
+            hordeNearMines[j] = mines[j]->hordeNearby();
+    };
+    auto aimCannons = [&](std::size_t begin, std::size_t end) {
+        for (std::size_t j=begin; j<end; j++) {
+            cannons[j]->recomputeDistribution(workersPositions);
+            cannonsThreatened[j] = lanes.framesToImpact(cannons[j]->getCoordinates(), Type::ENEMYBULLET) <= CANNON_REACTION;
+        }
+    };
+    JobGraph graph;
+    graph.add(mines.size(), JOBS_GRAIN, checkMines);
+    graph.add(cannons.size(), JOBS_GRAIN, aimCannons);
+    runJobs(jobs, graph);
+
+    for (std::size_t j=0; j<mines.size(); j++)
+        if (hordeNearMines[j])
+            mines[j]->trigger();
+    for (const std::shared_ptr<Worker>& worker : workers)
+        if (workerDistribution(rng))
+            worker->produce();
+    // removeNullptrs((std::vector<std::shared_ptr<Entity>>&)cannons);
+    for (const std::shared_ptr<ArmedWorker>& worker : armedWorkers) {
+        if (workerDistribution(rng))
+            worker->produce();
+        worker->dodgeIfNeeded();
+    }
+    for (std::size_t j=0; j<cannons.size(); j++)
+        if (cannons[j]->distribution(rng) || cannonsThreatened[j])
+            cannons[j]->fire(); // Firing at an incoming enemy bullet makes the two collide before the cannon is hit
+    // removeNullptrs((std::vector<std::shared_ptr<Entity>>&)bombers);
+    bombers.erase(
+        std::remove_if(
+            bombers.begin(),
+            bombers.end(),
+            [this](const std::shared_ptr<Bomber>& bomber) {
+                if (!bomber) return true;
+                if (bomber->exploded) {
+                    emit(ENTITY_KILLED, bomber.get());
+                    // Remove pawn from field before erasing
+                    field->erasePawn(bomber.get());
+                    return true;
+                }
+                return false;
+            }
+        ),
+        bombers.end()
+    );
+    for (unsigned j = 0; j < bombers.size(); j++) {
+        std::shared_ptr<Bomber> bomber = bombers[j];
+        if (bomber == nullptr) continue;
+        if (bomber->exploded) continue;
+        bomber->move();
+    }
+    try {
+        queen->move();
+    } catch (std::exception& e) {
+        // Nothing to do here
+    }
+    // removeNullptrs((std::vector<std::shared_ptr<Entity>>&)walls);
+    walls.erase(
+        std::remove_if(
+            walls.begin(),
+            walls.end(),
+            [this](const std::shared_ptr<Wall>& wall) {
+                if (!wall) return true;
+                if (wall->strength == 0) {
+                    emit(ENTITY_KILLED, wall.get());
+                    // Remove pawn from field before erasing
+                    field->erasePawn(wall.get());
+                    return true;
+                }
+                return false;
+            }
+        ),
+        walls.end()
+    );
+    for (unsigned j = 0; j < walls.size(); j++) {
+        std::shared_ptr<Wall> wall = walls[j];
+        if (wall == nullptr) continue;
+        if (wall->strength == 0) continue;
+    }
+    walls.erase(
+        std::remove_if(
+            walls.begin(),
+            walls.end(),
+            [this](const std::shared_ptr<Wall>& wall) {
+                if (!wall) return true;
+                if (wall->strength == 0) {
+                    emit(ENTITY_KILLED, wall.get());
+                    // Remove pawn from field before erasing
+                    field->erasePawn(wall.get());
+                    return true;
+                }
+                return false;
+            }
+        ),
+        walls.end()
+    );
+    // removeNullptrs((std::vector<std::shared_ptr<Entity>>&)bullets);
+    FrameVector<std::vector<std::shared_ptr<Mine>>::iterator> minesToRemove(arena); // We can't remove mines while iterating over them, so we store the iterators of the mines to remove
+    for (unsigned j=0; j<mines.size(); j++) {
+        if (j >= mines.size()) break;
+        if (mines[j] == nullptr) continue;
+        if (mines[j]->triggered()) {
+            mines[j]->explode();
+            minesToRemove.push_back(mines.begin() + j);
+        }
+    }
+    for (auto it = minesToRemove.rbegin(); it != minesToRemove.rend(); ++it) { // Back to front, so the remaining iterators stay valid
+        emit(ENTITY_KILLED, (*it)->get());
+        field->erasePawn((*it)->get());
+        mines.erase(*it);
+    }
+    minesToRemove.clear();
+
+    if (!spawnWaves(i, hardcore)) return false;
+    if (hardcore) {
+        // Too many zombies increase the probability of segfaults, so every REPOPULATE frames we empty and then repopulate the field
+        if (i % REPOPULATE == REPOPULATE - 1) {
+            field->clear();
+            field->addPrintPawn(player);
+            field->addPrintPawn(queen);
+            for (auto& wall : walls) {
+                field->addPrintPawn(wall);
+            }
+            for (auto& zombie : zombies) {
+                field->addPrintPawn(zombie);
+            }
+            for (auto& walker : walkers) {
+                field->addPrintPawn(walker);
+            }
+            for (auto& mine : mines) {
+                field->addPrintPawn(mine);
+            }
+            for (auto& cannon : cannons) {
+                field->addPrintPawn(cannon);
+            }
+            for (auto& worker : workers) {
+                field->addPrintPawn(worker);
+            }
+            for (auto& worker : armedWorkers) {
+                field->addPrintPawn(worker);
+            }
+            for (auto& bomber : bombers) {
+                field->addPrintPawn(bomber);
+            }
+        }
+    }
+    return true;
+}
+
+void GameWorld::removeCollidedProjectiles() {
+    bullets.erase(
+        std::remove_if(
+            bullets.begin(),
+            bullets.end(),
+            [this](const std::shared_ptr<Bullet>& bullet) {
+                if (!bullet) return true;
+                if (bullet->collided) {
+                    emit(ENTITY_KILLED, bullet.get());
+                    // Remove pawn from field before erasing
+                    lanes.erase(bullet.get());
+                    field->erasePawn(bullet.get());
+                    return true;
+                }
+                return false;
+            }
+        ),
+        bullets.end()
+    );
+    enemyBullets.erase(
+        std::remove_if(
+            enemyBullets.begin(),
+            enemyBullets.end(),
+            [this](const std::shared_ptr<EnemyBullet>& enemyBullet) {
+                if (!enemyBullet) return true;
+                if (enemyBullet->collided) {
+                    emit(ENTITY_KILLED, enemyBullet.get());
+                    // Remove pawn from field before erasing
+                    lanes.erase(enemyBullet.get());
+                    field->erasePawn(enemyBullet.get());
+                    return true;
+                }
+                return false;
+            }
+        ),
+        enemyBullets.end()
+    );
+}
+
+bool GameWorld::checkIntegrity(IntegrityReport& report) const {
+    report = IntegrityReport();
+    std::bitset<HEIGHT * WIDTH> listed; // Cells whose pawn was found in a list, the reverse index of the field
+    auto mismatch = [&report](IntegrityMismatch::Kind kind, Entity* entity, sista::Coordinates coordinates) {
+        if (report.mismatches < INTEGRITY_REPORTED)
+            report.first[report.mismatches] = {kind, entity->type, coordinates};
+        report.mismatches++;
+        trace(TRACE_ERROR, INTEGRITY_MISMATCH, entity->type, coordinates.y, coordinates.x, kind);
+    };
+    auto check = [&](Entity* entity) {
+        report.entities++;
+        sista::Coordinates coordinates = entity->getCoordinates();
+        if (field->isOutOfBounds(coordinates) || field->getPawn(coordinates) != entity) {
+            mismatch(IntegrityMismatch::Kind::MISSING, entity, coordinates);
+        } else if (listed[coordinates.y * WIDTH + coordinates.x]) {
+            mismatch(IntegrityMismatch::Kind::DUPLICATE, entity, coordinates);
+        } else {
+            listed[coordinates.y * WIDTH + coordinates.x] = true;
+        }
+    };
+    for (auto& bullet : bullets) check(bullet.get());
+    for (auto& enemyBullet : enemyBullets) check(enemyBullet.get());
+    for (auto& zombie : zombies) check(zombie.get());
+    for (auto& walker : walkers) check(walker.get());
+    for (auto& wall : walls) check(wall.get());
+    for (auto& mine : mines) check(mine.get());
+    for (auto& cannon : cannons) check(cannon.get());
+    for (auto& worker : armedWorkers) check(worker.get());
+    for (auto& worker : workers) check(worker.get());
+    for (auto& bomber : bombers) check(bomber.get());
+    check(player.get());
+    check(queen.get());
+
+    for (unsigned short y=0; y<HEIGHT; y++) {
+        for (unsigned short x=0; x<WIDTH; x++) {
+            if (listed[y * WIDTH + x]) continue;
+            Entity* pawn = (Entity*)field->getPawn(y, x);
+            if (pawn == nullptr) continue;
+            mismatch(IntegrityMismatch::Kind::UNLISTED, pawn, {y, x});
+        }
+    }
+    return report.mismatches == 0;
+}
+
+static void setCollided(Entity* projectile) {
+    if (projectile->type == Type::BULLET)
+        ((Bullet*)projectile)->collided = true;
+    else
+        ((EnemyBullet*)projectile)->collided = true;
+}
+
+void GameWorld::moveProjectiles() {
+    unsigned short steps = 0;
+    for (auto& bullet : bullets)
+        steps = std::max(steps, bullet->speed);
+    for (auto& enemyBullet : enemyBullets)
+        steps = std::max(steps, enemyBullet->speed);
+    intentAt.assign(WIDTH * HEIGHT, -1);
+    claimedBy.assign(WIDTH * HEIGHT, -1);
+    // A projectile of speed s takes one-cell steps in the first s steps of the frame
+    for (unsigned short step=0; step<steps; step++) {
+        // Intent phase: every projectile proposes its next cell, nothing is changed
+        intents.clear();
+        for (auto& bullet : bullets)
+            if (!bullet->collided && bullet->speed > step)
+                intents.push_back({bullet.get(), bullet->getCoordinates(), bullet->getCoordinates() + directionOffset(bullet->direction), MoveIntent::PENDING});
+        for (auto& enemyBullet : enemyBullets)
+            if (!enemyBullet->collided && enemyBullet->speed > step)
+                intents.push_back({enemyBullet.get(), enemyBullet->getCoordinates(), enemyBullet->getCoordinates() + directionOffset(enemyBullet->direction), MoveIntent::PENDING});
+        if (intents.empty())
+            break;
+
+        // Commit phase: conflicts between projectiles first, they don't depend on the order of the intents
+        for (int j=0; j<(int)intents.size(); j++) {
+            MoveIntent& intent = intents[j];
+            intentAt[intent.from.y*WIDTH + intent.from.x] = j;
+            if (field->isOutOfBounds(intent.to)) {
+                setCollided(intent.projectile);
+                intent.state = MoveIntent::DONE;
+                continue;
+            }
+            int& claim = claimedBy[intent.to.y*WIDTH + intent.to.x];
+            if (claim >= 0) { // Two projectiles entering the same cell destroy each other
+                setCollided(intent.projectile);
+                setCollided(intents[claim].projectile);
+                intent.state = MoveIntent::DONE;
+                intents[claim].state = MoveIntent::DONE;
+            } else {
+                claim = j;
+            }
+        }
+        for (MoveIntent& intent : intents) {
+            if (intent.state != MoveIntent::PENDING)
+                continue;
+            int other = intentAt[intent.to.y*WIDTH + intent.to.x];
+            if (other >= 0 && intents[other].state == MoveIntent::PENDING && intents[other].to.y == intent.from.y && intents[other].to.x == intent.from.x) { // Head-on, they would swap cells
+                setCollided(intent.projectile);
+                setCollided(intents[other].projectile);
+                intent.state = MoveIntent::DONE;
+                intents[other].state = MoveIntent::DONE;
+            }
+        }
+        // Then the moves, repeated while a projectile waits for the one in front of it to leave its cell
+        bool progress = true;
+        while (progress) {
+            progress = false;
+            for (MoveIntent& intent : intents) {
+                if (intent.state != MoveIntent::PENDING)
+                    continue;
+                Entity* hitten = (Entity*)field->getPawn(intent.to);
+                if (hitten == nullptr) {
+                    lanes.move(intent.projectile, intent.to);
+                    field->movePawn(intent.projectile, intent.to);
+                    intent.state = MoveIntent::DONE;
+                } else if (typeTraits[hitten->type].collision == PROJECTILE) {
+                    int other = intentAt[intent.to.y*WIDTH + intent.to.x];
+                    if (other >= 0 && intents[other].state == MoveIntent::PENDING)
+                        continue; // It may still leave
+                    setCollided(intent.projectile); // It stays there, so they meet
+                    setCollided(hitten);
+                    intent.state = MoveIntent::DONE;
+                } else if (intent.projectile->type == Type::BULLET) {
+                    ((Bullet*)intent.projectile)->hit(hitten);
+                    intent.state = MoveIntent::DONE;
+                } else {
+                    ((EnemyBullet*)intent.projectile)->hit(hitten);
+                    intent.state = MoveIntent::DONE;
+                }
+                progress = true;
+            }
+        }
+        for (MoveIntent& intent : intents) {
+            if (intent.state == MoveIntent::PENDING) // Only a loop of projectiles chasing each other can be left, they all meet
+                setCollided(intent.projectile);
+            intentAt[intent.from.y*WIDTH + intent.from.x] = -1;
+            if (!field->isOutOfBounds(intent.to))
+                claimedBy[intent.to.y*WIDTH + intent.to.x] = -1;
+        }
+    }
+}
+
+void GameWorld::clear() {
+    bullets.clear();
+    enemyBullets.clear();
+    zombies.clear();
+    walkers.clear();
+    walls.clear();
+    mines.clear();
+    cannons.clear();
+    armedWorkers.clear();
+    workers.clear();
+    bombers.clear();
+    player.reset();
+    queen.reset();
+    lanes.clear();
+    field->clear();
+    end = false;
+}
+
+static bool onField(HashedField& field, Entity* entity) {
+    return !field.isOutOfBounds(entity->getCoordinates()) && field.getPawn(entity->getCoordinates()) == entity;
+}
+template <typename T>
+static void lift(HashedField& field, const std::shared_ptr<T>& entity) { // Takes the entity off the field, if it is on it
+    if (entity != nullptr && onField(field, entity.get()))
+        field.erasePawn(entity.get());
+}
+template <typename T>
+static void lift(HashedField& field, const std::vector<std::shared_ptr<T>>& list) {
+    for (const std::shared_ptr<T>& entity : list)
+        lift(field, entity);
+}
+// Copies the entity into the other world, over the entity it already had if any, and on its field if the entity is on this one
+template <typename T>
+static void forkEntity(HashedField& field, const std::shared_ptr<T>& entity, GameWorld& world, std::shared_ptr<T>& copy) {
+    if (entity == nullptr) {
+        copy.reset();
+        return;
+    }
+    if (copy != nullptr)
+        *copy = *entity;
+    else
+        copy = makeEntity<T>(*entity);
+    copy->world = &world;
+    if (onField(field, entity.get()))
+        world.field->addPawn(copy);
+}
+template <typename T>
+static void mapList(const std::vector<std::shared_ptr<T>>& list, GameWorld& world, std::unordered_map<sista::Pawn*, std::shared_ptr<Entity>>& copies) {
+    for (std::size_t j=0; j<list.size(); j++)
+        if (list[j] != nullptr)
+            copies[list[j].get()] = world.list<T>()[j];
+}
+template <typename T>
+static void forkList(HashedField& field, const std::vector<std::shared_ptr<T>>& list, GameWorld& world) {
+    std::vector<std::shared_ptr<T>>& copies = world.list<T>();
+    copies.resize(list.size()); // The extra entities go back to their pool
+    for (std::size_t j=0; j<list.size(); j++)
+        forkEntity(field, list[j], world, copies[j]);
+}
+
+template <typename T>
+static std::shared_ptr<Entity> copyPawn(Entity* pawn, GameWorld& world) {
+    std::shared_ptr<T> copy = makeEntity<T>(*(T*)pawn);
+    copy->world = &world;
+    return copy;
+}
+// A copy of a pawn left on the field by an entity that is in no list any more (it was moved away from its coordinates,
+// so removing the entity missed it). It still blocks and gets hit, so the other world needs it too, owned by its field alone.
+static std::shared_ptr<Entity> forkUnlisted(Entity* pawn, GameWorld& world) {
+    switch (pawn->type) {
+    case Type::PLAYER: return copyPawn<Player>(pawn, world);
+    case Type::WORKER: return copyPawn<Worker>(pawn, world);
+    case Type::ARMED_WORKER: return copyPawn<ArmedWorker>(pawn, world);
+    case Type::CANNON: return copyPawn<Cannon>(pawn, world);
+    case Type::BOMBER: return copyPawn<Bomber>(pawn, world);
+    case Type::BULLET: return copyPawn<Bullet>(pawn, world);
+    case Type::MINE: return copyPawn<Mine>(pawn, world);
+    case Type::WALL: return copyPawn<Wall>(pawn, world);
+    case Type::ZOMBIE: return copyPawn<Zombie>(pawn, world);
+    case Type::WALKER: return copyPawn<Walker>(pawn, world);
+    case Type::ENEMYBULLET: return copyPawn<EnemyBullet>(pawn, world);
+    case Type::QUEEN: return copyPawn<Queen>(pawn, world);
+    }
+    return nullptr;
+}
+
+void GameWorld::fork(GameWorld& world) const {
+    // The old entities of the other world leave its field before any is overwritten, as the hash depends on their looks
+    HashedField& copyField = *world.field;
+    lift(copyField, world.player);
+    lift(copyField, world.queen);
+    lift(copyField, world.bullets);
+    lift(copyField, world.enemyBullets);
+    lift(copyField, world.zombies);
+    lift(copyField, world.walkers);
+    lift(copyField, world.walls);
+    lift(copyField, world.mines);
+    lift(copyField, world.cannons);
+    lift(copyField, world.armedWorkers);
+    lift(copyField, world.workers);
+    lift(copyField, world.bombers);
+    if (copyField.hash != 0) // Pawns that weren't in any list
+        copyField.clear();
+
+    forkEntity(*field, player, world, world.player);
+    forkEntity(*field, queen, world, world.queen);
+    forkList(*field, bullets, world);
+    forkList(*field, enemyBullets, world);
+    forkList(*field, zombies, world);
+    forkList(*field, walkers, world);
+    forkList(*field, walls, world);
+    forkList(*field, mines, world);
+    forkList(*field, cannons, world);
+    forkList(*field, armedWorkers, world);
+    forkList(*field, workers, world);
+    forkList(*field, bombers, world);
+    if (copyField.hash != field->hash) {
+        // Some pawns aren't in the cell of their coordinates: an entity that a horde was spawned over moved the pawn of
+        // the horde with it. The copies are placed cell by cell instead, where the pawns they copy are, and the pawns
+        // such entities left behind when they were removed are copied on their own.
+        std::unordered_map<sista::Pawn*, std::shared_ptr<Entity>> copies;
+        copies[player.get()] = world.player;
+        copies[queen.get()] = world.queen;
+        mapList(bullets, world, copies);
+        mapList(enemyBullets, world, copies);
+        mapList(zombies, world, copies);
+        mapList(walkers, world, copies);
+        mapList(walls, world, copies);
+        mapList(mines, world, copies);
+        mapList(cannons, world, copies);
+        mapList(armedWorkers, world, copies);
+        mapList(workers, world, copies);
+        mapList(bombers, world, copies);
+        copyField.clear();
+        for (unsigned short y=0; y<HEIGHT; y++) {
+            for (unsigned short x=0; x<WIDTH; x++) {
+                Entity* pawn = (Entity*)field->getPawn(y, x);
+                if (pawn == nullptr)
+                    continue;
+                auto listed = copies.find(pawn);
+                std::shared_ptr<Entity> copy = listed != copies.end() ? listed->second : forkUnlisted(pawn, world);
+                sista::Coordinates coordinates = copy->getCoordinates();
+                sista::Coordinates cell(y, x);
+                copy->setCoordinates(cell);
+                copyField.addPawn(copy);
+                copy->setCoordinates(coordinates);
+            }
+        }
+    }
+    world.lanes.clear();
+    for (const std::shared_ptr<Bullet>& bullet : world.bullets)
+        if (bullet != nullptr)
+            world.lanes.insert(bullet.get());
+    for (const std::shared_ptr<EnemyBullet>& enemyBullet : world.enemyBullets)
+        if (enemyBullet != nullptr)
+            world.lanes.insert(enemyBullet.get());
+    world.flowField = flowField;
+
+    world.end = end;
+    world.paused = paused;
+    world.rng = rng;
+    world.balance = balance;
+    world.scenario = scenario;
+    world.zombieDistribution = zombieDistribution;
+    world.zombieShootDistribution = zombieShootDistribution;
+    world.walkerDistribution = walkerDistribution;
+    world.workerDistribution = workerDistribution;
+    world.events.clear();
+}
+
+Scenario defaultScenario() {
+    Scenario scenario;
+    scenario.placements.push_back({Type::PLAYER, {10, 18}});
+    scenario.placements.push_back({Type::QUEEN, {10, 49}});
+    for (unsigned short j=0; j<20; j++) {
+        scenario.placements.push_back({Type::WALL, {j, 30}, 3}); // There is a vertical macrowall in the middle of the field
+        if (j % 5 == 1)
+            scenario.placements.push_back({Type::ZOMBIE, {j, 47}}); // Zombies are spawned on the right side of the field (the mother side)
+        if (j % 5 == 3)
+            scenario.placements.push_back({Type::WALKER, {j, 45}}); // Walkers are spawned on the right side of the field (the mother side)
+        if (j % 5 == 2)
+            scenario.placements.push_back({Type::WORKER, {j, 1}}); // Workers are spawned on the left side of the field (the player side)
+    }
+    scenario.waves.push_back({Type::WALKER, 100, 0});
+    scenario.waves.push_back({Type::ZOMBIE, 200, 0});
+    // The point of the hardcore mode is to survive as long as possible, so the spawning rate of the enemies increases over time:
+    // the hordes of enemies are spawned every 500 frames, but the number of enemies in each horde increases over time
+    scenario.waves.push_back({Type::WALKER, 500, 250, 0, 100, true});
+    scenario.waves.push_back({Type::ZOMBIE, 500, 250, 0, 200, true});
+    return scenario;
+}
+
+template <typename T, typename... Args>
+static void place(GameWorld* world, sista::Coordinates coordinates, Args&&... args) {
+    std::shared_ptr<T> entity = makeEntity<T>(world, coordinates, std::forward<Args>(args)...);
+    world->list<T>().push_back(entity);
+    world->field->addPawn(entity);
+}
+
+void GameWorld::finish(bool won) {
+    end = true;
+    emit(GAME_ENDED, won ? (Entity*)queen.get() : (Entity*)player.get(), won);
+}
+
+// The ammonitions and the life are tagged in the high bits, out of the range of the keys of the cells
+uint64_t GameWorld::stateHash() const {
+    uint64_t hash = field->hash;
+    if (player != nullptr)
+        hash ^= mix64((uint64_t)1 << 32 | (uint32_t)player->ammonitions);
+    if (queen != nullptr)
+        hash ^= mix64((uint64_t)2 << 32 | (uint32_t)queen->life);
+    return hash;
+}
+
+std::size_t GameWorld::entityCount(Type type) const {
+    switch (type) { // No default, so that a Type without a case is a warning
+    case Type::PLAYER: return player != nullptr;
+    case Type::WORKER: return workers.size();
+    case Type::ARMED_WORKER: return armedWorkers.size();
+    case Type::CANNON: return cannons.size();
+    case Type::BOMBER: return bombers.size();
+    case Type::BULLET: return bullets.size();
+    case Type::MINE: return mines.size();
+    case Type::WALL: return walls.size();
+    case Type::ZOMBIE: return zombies.size();
+    case Type::WALKER: return walkers.size();
+    case Type::ENEMYBULLET: return enemyBullets.size();
+    case Type::QUEEN: return queen != nullptr;
+    }
+    return 0;
+}
+
+std::size_t GameWorld::entityCount() const {
+    std::size_t count = 0;
+    for (unsigned type=0; type<=Type::QUEEN; type++)
+        count += entityCount((Type)type);
+    return count;
+}
+
+uint64_t HashedField::recompute() {
+    uint64_t hash = 0;
+    for (unsigned short y=0; y<HEIGHT; y++) {
+        for (unsigned short x=0; x<WIDTH; x++) {
+            Entity* entity = (Entity*)getPawn(y, x);
+            if (entity != nullptr)
+                hash ^= zobristKey(y * WIDTH + x, entity->style);
+        }
+    }
+    return hash;
+}
+
+void GameWorld::populate() {
+    for (const Placement& placement : scenario.placements) {
+        switch (placement.type) {
+        case Type::PLAYER:
+            player = makeEntity<Player>(this, placement.coordinates);
+            field->addPawn(player);
+            break;
+        case Type::QUEEN:
+            queen = makeEntity<Queen>(this, placement.coordinates);
+            field->addPawn(queen);
+            break;
+        case Type::WORKER: place<Worker>(this, placement.coordinates); break;
+        case Type::ARMED_WORKER: place<ArmedWorker>(this, placement.coordinates); break;
+        case Type::CANNON: place<Cannon>(this, placement.coordinates, balance.cannonFirePeriod); break;
+        case Type::BOMBER: place<Bomber>(this, placement.coordinates); break;
+        case Type::MINE: place<Mine>(this, placement.coordinates); break;
+        case Type::WALL: place<Wall>(this, placement.coordinates, placement.strength); break;
+        case Type::ZOMBIE: place<Zombie>(this, placement.coordinates); break;
+        case Type::WALKER: place<Walker>(this, placement.coordinates); break;
+        default: break; // Projectiles aren't placed, loadScenario rejects them
+        }
+    }
+}
+
+bool GameWorld::spawnWaves(unsigned i, bool hardcore) {
+    for (const Wave& wave : scenario.waves) {
+        if (i % wave.period != wave.phase || (wave.hardcore && !hardcore))
+            continue;
+        unsigned count = wave.count + (wave.growth ? i / wave.growth : 0);
+        for (unsigned j=0; j<count; j++) {
+            unsigned short y = rand() % HEIGHT;
+            if (queen->getCoordinates().y == y)
+                continue;
+            sista::Coordinates coordinates{y, WIDTH - 1};
+            if (!wave.horde() && field->isOccupied(coordinates)) return false;
+            if (wave.type == Type::WALKER) {
+                spawn<Walker>(coordinates);
+            } else {
+                spawn<Zombie>(coordinates);
+            }
+        }
+    }
+    return true;
+}
+
+#define STYLE(symbol, foreground, background, attribute) {symbol, {sista::ForegroundColor::foreground, sista::BackgroundColor::background, sista::Attribute::attribute}}
+Style styles[STYLES] = {
+    STYLE('$', RED, BLACK, BRIGHT), // PLAYER_STYLE
+    STYLE('W', YELLOW, BLACK, UNDERSCORE), // WORKER_STYLE
+    STYLE('W', YELLOW, BLUE, UNDERSCORE), // ARMED_WORKER_STYLE
+    STYLE('C', RED, BLACK, BRIGHT), // CANNON_STYLE
+    STYLE('B', BLUE, BLACK, BRIGHT), // BOMBER_STYLE
+    STYLE('^', MAGENTA, BLACK, BRIGHT), STYLE('>', MAGENTA, BLACK, BRIGHT), // BULLET_STYLE + Direction
+    STYLE('v', MAGENTA, BLACK, BRIGHT), STYLE('<', MAGENTA, BLACK, BRIGHT),
+    STYLE('^', GREEN, BLACK, BRIGHT), STYLE('>', GREEN, BLACK, BRIGHT), // ENEMYBULLET_STYLE + Direction
+    STYLE('v', GREEN, BLACK, BRIGHT), STYLE('<', GREEN, BLACK, BRIGHT),
+    STYLE('=', YELLOW, BLACK, BRIGHT), // WALL_STYLE
+    STYLE('@', YELLOW, BLACK, BRIGHT), // DESTROYED_WALL_STYLE
+    STYLE('*', MAGENTA, BLACK, BLINK), // MINE_STYLE
+    STYLE('%', WHITE, BLACK, BRIGHT), // TRIGGERED_MINE_STYLE
+    STYLE('Z', BLACK, GREEN, FAINT), // ZOMBIE_STYLE
+    STYLE('Z', BLACK, GREEN, BRIGHT), // WALKER_STYLE
+    STYLE('0', BLACK, RED, BRIGHT), STYLE('1', BLACK, RED, BRIGHT), // QUEEN_STYLE + life
+    STYLE('2', BLACK, RED, BRIGHT), STYLE('3', BLACK, RED, BRIGHT),
+    STYLE('4', BLACK, RED, BRIGHT), STYLE('5', BLACK, RED, BRIGHT),
+    STYLE('6', BLACK, RED, BRIGHT), STYLE('7', BLACK, RED, BRIGHT),
+    STYLE('8', BLACK, RED, BRIGHT), STYLE('9', BLACK, RED, BRIGHT)
+};
+#undef STYLE
+
+const char* typeNames[Type::QUEEN + 1] = {
+    "player", "worker", "armed_worker", "cannon", "bomber", "bullet", "mine",
+    "wall", "zombie", "walker", "enemy_bullet", "queen"
+};
+
+const char* gameEventNames[GAME_EVENT_KINDS] = {
+    "queen_damaged", "wall_destroyed", "entity_spawned", "entity_killed", "ammo_changed", "ammo_empty", "game_ended"
+};
+
+static Direction directionOf(Entity* projectile) {
+    return projectile->type == Type::BULLET ? ((Bullet*)projectile)->direction : ((EnemyBullet*)projectile)->direction;
+}
+static unsigned short speedOf(Entity* projectile) {
+    return std::max<unsigned short>(1, projectile->type == Type::BULLET ? ((Bullet*)projectile)->speed : ((EnemyBullet*)projectile)->speed);
+}
+static bool hasCollided(Entity* projectile) { // Collided projectiles stay in their lane until the frame loop removes them
+    return projectile->type == Type::BULLET ? ((Bullet*)projectile)->collided : ((EnemyBullet*)projectile)->collided;
+}
+
+ProjectileLanes::Lane& ProjectileLanes::laneOf(Entity* projectile, sista::Coordinates coordinates) {
+    bool enemy = projectile->type == Type::ENEMYBULLET;
+    switch (directionOf(projectile)) {
+    case Direction::LEFT: return rows[coordinates.y][enemy][1];
+    case Direction::RIGHT: return rows[coordinates.y][enemy][0];
+    case Direction::UP: return columns[coordinates.x][enemy][1];
+    default: return columns[coordinates.x][enemy][0];
+    }
+}
+void ProjectileLanes::insert(Entity* projectile) {
+    sista::Coordinates coordinates = projectile->getCoordinates();
+    bool horizontal = directionOf(projectile) == Direction::LEFT || directionOf(projectile) == Direction::RIGHT;
+    laneOf(projectile, coordinates).insert({horizontal ? coordinates.x : coordinates.y, projectile});
+    maxSpeed = std::max(maxSpeed, speedOf(projectile));
+}
+void ProjectileLanes::erase(Entity* projectile) {
+    sista::Coordinates coordinates = projectile->getCoordinates();
+    bool horizontal = directionOf(projectile) == Direction::LEFT || directionOf(projectile) == Direction::RIGHT;
+    laneOf(projectile, coordinates).erase({horizontal ? coordinates.x : coordinates.y, projectile});
+}
+void ProjectileLanes::move(Entity* projectile, sista::Coordinates destination) {
+    erase(projectile);
+    bool horizontal = directionOf(projectile) == Direction::LEFT || directionOf(projectile) == Direction::RIGHT;
+    laneOf(projectile, destination).insert({horizontal ? destination.x : destination.y, projectile}); // Projectiles never change lane
+}
+void ProjectileLanes::clear() {
+    for (auto& row : rows)
+        for (auto& kind : row)
+            for (Lane& lane : kind)
+                lane.clear();
+    for (auto& column : columns)
+        for (auto& kind : column)
+            for (Lane& lane : kind)
+                lane.clear();
+    maxSpeed = 1;
+}
+unsigned ProjectileLanes::framesToImpact(sista::Coordinates cell, Type type) const {
+    bool enemy = type == Type::ENEMYBULLET;
+    unsigned best = LANES_NO_IMPACT;
+    // Lanes are sorted by distance from the cell, a projectile can't arrive sooner than distance/maxSpeed frames, so the scan stops there
+    auto consider = [&](unsigned short distance, Entity* projectile) {
+        if ((distance + maxSpeed - 1u) / maxSpeed >= best)
+            return false;
+        if (!hasCollided(projectile))
+            best = std::min(best, (distance + speedOf(projectile) - 1u) / speedOf(projectile));
+        return true;
+    };
+    const Lane& fromRight = rows[cell.y][enemy][1]; // Moving left, so coming from greater x
+    for (auto it = fromRight.upper_bound({cell.x, (Entity*)UINTPTR_MAX}); it != fromRight.end(); ++it)
+        if (!consider(it->first - cell.x, it->second)) break;
+    const Lane& fromLeft = rows[cell.y][enemy][0];
+    for (auto it = std::make_reverse_iterator(fromLeft.lower_bound({cell.x, nullptr})); it != fromLeft.rend(); ++it)
+        if (!consider(cell.x - it->first, it->second)) break;
+    const Lane& fromBelow = columns[cell.x][enemy][1]; // Moving up, so coming from greater y
+    for (auto it = fromBelow.upper_bound({cell.y, (Entity*)UINTPTR_MAX}); it != fromBelow.end(); ++it)
+        if (!consider(it->first - cell.y, it->second)) break;
+    const Lane& fromAbove = columns[cell.x][enemy][0];
+    for (auto it = std::make_reverse_iterator(fromAbove.lower_bound({cell.y, nullptr})); it != fromAbove.rend(); ++it)
+        if (!consider(cell.y - it->first, it->second)) break;
+    return best;
+}
+
+FlowField::FlowField() : distances(HEIGHT * WIDTH, FLOW_UNREACHABLE), directions(HEIGHT * WIDTH, Direction::LEFT), costs(HEIGHT * WIDTH, 0), nextCosts(HEIGHT * WIDTH) {}
+void FlowField::update(const GameWorld& world) {
+    // Moves a walker spends to enter each cell: the ones to break what's there, plus the step. 0 if it can't get through.
+    std::fill(nextCosts.begin(), nextCosts.end(), 1);
+    auto set = [this](Entity* entity, uint8_t cost) {
+        sista::Coordinates coordinates = entity->getCoordinates();
+        if (coordinates.y < HEIGHT && coordinates.x < WIDTH)
+            nextCosts[coordinates.y * WIDTH + coordinates.x] = cost;
+    };
+    for (auto& wall : world.walls) // A destroyed wall (strength 0) blocks for a move, then it's removed
+        set(wall.get(), std::min<int>(1 + std::max<short>(wall->strength, 1), FLOW_MAX_COST));
+    for (auto& mine : world.mines) // It would explode and take the walker with it
+        set(mine.get(), FLOW_MAX_COST);
+    for (auto& cannon : world.cannons) // Destroyed by the first move, entered by the second
+        set(cannon.get(), 2);
+    for (auto& worker : world.workers)
+        set(worker.get(), 2);
+    for (auto& worker : world.armedWorkers)
+        set(worker.get(), 2);
+    if (world.queen)
+        set(world.queen.get(), 0);
+    if (nextCosts == costs)
+        return; // Nothing in the way changed since the last update
+    costs.swap(nextCosts);
+
+    // Dijkstra from the left edge with a bucket queue (Dial): the costs are small integers, so the distances being
+    // settled span at most FLOW_MAX_COST + 1 consecutive values, one bucket each
+    std::fill(distances.begin(), distances.end(), FLOW_UNREACHABLE);
+    std::fill(directions.begin(), directions.end(), Direction::LEFT);
+    for (unsigned short y=0; y<HEIGHT; y++) {
+        distances[y * WIDTH] = 1; // Stepping out of the left edge is the touchdown
+        buckets[1].push_back(y * WIDTH);
+    }
+    std::size_t pending = HEIGHT;
+    for (unsigned distance=1; pending > 0; distance++) {
+        std::vector<unsigned short>& bucket = buckets[distance % (FLOW_MAX_COST + 1)];
+        for (unsigned short cell : bucket) { // The costs are at least 1, nothing is added to this bucket while it's scanned
+            pending--;
+            if (distances[cell] != distance || costs[cell] == 0)
+                continue; // Reached again later with a shorter distance, or impassable
+            unsigned entered = distance + costs[cell];
+            // The neighbors step into the cell in the opposite direction of the one they are in
+            auto relax = [&](unsigned short from, Direction direction) {
+                if (entered < distances[from]) {
+                    distances[from] = entered;
+                    directions[from] = direction;
+                    buckets[entered % (FLOW_MAX_COST + 1)].push_back(from);
+                    pending++;
+                }
+            };
+            if (cell % WIDTH + 1 < WIDTH)
+                relax(cell + 1, Direction::LEFT);
+            if (cell >= WIDTH)
+                relax(cell - WIDTH, Direction::DOWN);
+            if (cell + WIDTH < HEIGHT * WIDTH)
+                relax(cell + WIDTH, Direction::UP);
+            if (cell % WIDTH > 0)
+                relax(cell - 1, Direction::RIGHT);
+        }
+        bucket.clear();
+    }
+}
+
+Entity::Entity(GameWorld* world, sista::Coordinates coordinates, StyleId style, Type type) : sista::Pawn(styles[style].symbol, coordinates, styles[style].settings), type(type), style(style), world(world) {}
+Entity::Entity() : Entity(nullptr, sista::Coordinates(0, 0), PLAYER_STYLE, Type::PLAYER) {}
+void Entity::setStyle(StyleId style) {
+    if (world != nullptr && !world->field->isOutOfBounds(coordinates) && world->field->getPawn(coordinates) == this) {
+        unsigned cell = coordinates.y * WIDTH + coordinates.x;
+        world->field->hash ^= zobristKey(cell, this->style) ^ zobristKey(cell, style);
+    }
+    this->style = style;
+    symbol = styles[style].symbol;
+    settings = styles[style].settings;
+}
+
+void Bullet::removeBullet(std::shared_ptr<Bullet> bullet) {
+    bullet->world->emit(ENTITY_KILLED, bullet.get());
+    bullet->world->bullets.erase(std::find(bullet->world->bullets.begin(), bullet->world->bullets.end(), bullet));
+    bullet->world->lanes.erase(bullet.get());
+    bullet->world->field->erasePawn(bullet.get());
+    trace(TRACE_DEBUG, BULLET_REMOVED, Type::BULLET, bullet->getCoordinates().y, bullet->getCoordinates().x, bullet->world->bullets.size());
+}
+void Bullet::removeBullet(Bullet* bullet) {
+    auto it = std::find_if(bullet->world->bullets.begin(), bullet->world->bullets.end(),
+        [bullet](const std::shared_ptr<Bullet>& b) { return b.get() == bullet; });
+    if (it != bullet->world->bullets.end()) {
+        bullet->world->emit(ENTITY_KILLED, bullet);
+        sista::Coordinates coordinates = bullet->getCoordinates();
+        GameWorld* world = bullet->world;
+        world->lanes.erase(bullet);
+        world->field->erasePawn(bullet);
+        world->bullets.erase(it); // Last, it can destroy the bullet
+        trace(TRACE_DEBUG, BULLET_REMOVED, Type::BULLET, coordinates.y, coordinates.x, world->bullets.size());
+    }
+}
+Bullet::Bullet() : Entity(nullptr, {0, 0}, (StyleId)(BULLET_STYLE + Direction::RIGHT), Type::BULLET), direction(Direction::RIGHT), speed(1) {}
+Bullet::Bullet(GameWorld* world, sista::Coordinates coordinates, Direction direction) : Entity(world, coordinates, (StyleId)(BULLET_STYLE + direction), Type::BULLET), direction(direction), speed(world->balance.projectileSpeed) {}
+Bullet::Bullet(GameWorld* world, sista::Coordinates coordinates, Direction direction, unsigned short speed) : Entity(world, coordinates, (StyleId)(BULLET_STYLE + direction), Type::BULLET), direction(direction), speed(speed) {}
+void Bullet::hit(Entity* hitten) {
+    if (hitten->type == Type::WALL) {
+        Wall* wall = (Wall*)hitten;
+        wall->strength--;
+        if (wall->strength == 0)
+            wall->destroy();
+    } else if (hitten->type == Type::ZOMBIE) {
+        Zombie::removeZombie((Zombie*)hitten);
+    } else if (hitten->type == Type::WALKER) {
+        Walker::removeWalker((Walker*)hitten);
+    } else if (hitten->type == Type::MINE) {
+        Mine* mine = (Mine*)hitten;
+        mine->setStyle(TRIGGERED_MINE_STYLE);
+    } else if (hitten->type == Type::CANNON) {
+        Cannon* cannon = (Cannon*)hitten;
+        // Makes the cannon fire
+        cannon->fire();
+    } else if (hitten->type == Type::QUEEN) {
+        ((Queen*)hitten)->damage();
+    }
+    this->collided = true; // Marking for removal
+}
+
+
+EnemyBullet::EnemyBullet(GameWorld* world, sista::Coordinates coordinates, Direction direction, unsigned short speed) : Entity(world, coordinates, (StyleId)(ENEMYBULLET_STYLE + direction), Type::ENEMYBULLET), direction(direction), speed(speed) {}
+EnemyBullet::EnemyBullet(GameWorld* world, sista::Coordinates coordinates, Direction direction) : Entity(world, coordinates, (StyleId)(ENEMYBULLET_STYLE + direction), Type::ENEMYBULLET), direction(direction), speed(world->balance.projectileSpeed) {}
+EnemyBullet::EnemyBullet() : Entity(nullptr, {0, 0}, (StyleId)(ENEMYBULLET_STYLE + Direction::UP), Type::ENEMYBULLET), direction(Direction::UP), speed(1) {}
+void EnemyBullet::removeEnemyBullet(std::shared_ptr<EnemyBullet> enemyBullet) {
+    enemyBullet->world->emit(ENTITY_KILLED, enemyBullet.get());
+    enemyBullet->world->enemyBullets.erase(std::find(enemyBullet->world->enemyBullets.begin(), enemyBullet->world->enemyBullets.end(), enemyBullet));
+    enemyBullet->world->lanes.erase(enemyBullet.get());
+    enemyBullet->world->field->erasePawn(enemyBullet.get());
+}
+void EnemyBullet::removeEnemyBullet(EnemyBullet* enemyBullet) {
+    for (auto it = enemyBullet->world->enemyBullets.begin(); it != enemyBullet->world->enemyBullets.end(); ++it) {
+        if (it->get() == enemyBullet) {
+            enemyBullet->world->emit(ENTITY_KILLED, enemyBullet);
+            enemyBullet->world->lanes.erase(enemyBullet);
+            enemyBullet->world->field->erasePawn(enemyBullet);
+            enemyBullet->world->enemyBullets.erase(it);
+            return;
+        }
+    }
+}
+void EnemyBullet::hit(Entity* hitten) {
+    if (hitten->type == Type::PLAYER) {
+        world->finish(false);
+    } else if (hitten->type == Type::WALL) {
+        Wall* wall = (Wall*)hitten;
+        wall->strength--;
+        if (wall->strength == 0)
+            wall->destroy();
+    } else if (typeTraits[hitten->type].collision == HORDE) {
+        // No friendly fire
+    } else if (hitten->type == Type::MINE) {
+        Mine* mine = (Mine*)hitten;
+        mine->setStyle(TRIGGERED_MINE_STYLE);
+    } else if (hitten->type == Type::CANNON) { // The cannon is destroyed by the enemy bullet
+        Cannon::removeCannon((Cannon*)hitten);
+    } else if (hitten->type == Type::WORKER) {
+        Worker::removeWorker((Worker*)hitten);
+    } else if (hitten->type == Type::ARMED_WORKER) {
+        ArmedWorker::removeArmedWorker((ArmedWorker*)hitten);
+    } else if (hitten->type == Type::BOMBER) {
+        Bomber::removeBomber((Bomber*)hitten);
+    }
+    this->collided = true; // Mark for removal
+}
+
+// Places a T in front of the player, passing its constructor what it needs besides the world and the coordinates
+template <typename T>
+static void placeUnit(Player* player, sista::Coordinates spawn, Direction) {
+    player->world->spawn<T>(spawn);
+}
+template <>
+void placeUnit<Bullet>(Player* player, sista::Coordinates spawn, Direction direction) {
+    player->world->spawn<Bullet>(spawn, direction, player->speed);
+}
+template <>
+void placeUnit<Cannon>(Player* player, sista::Coordinates spawn, Direction) {
+    player->world->spawn<Cannon>(spawn, player->world->balance.cannonFirePeriod);
+}
+template <>
+void placeUnit<Wall>(Player* player, sista::Coordinates spawn, Direction) {
+    player->world->spawn<Wall>(spawn, typeTraits[Type::WALL].strength);
+}
+typedef void (*Placer)(Player*, sista::Coordinates, Direction);
+static constexpr Placer placers[Type::QUEEN + 1] = { // Indexed by Player::weapon, nullptr for what can't be placed
+    nullptr, placeUnit<Worker>, placeUnit<ArmedWorker>, placeUnit<Cannon>, placeUnit<Bomber>, placeUnit<Bullet>, placeUnit<Mine>,
+    placeUnit<Wall>, nullptr, nullptr, nullptr, nullptr
+};
+static constexpr bool placersMatchCosts() {
+    for (unsigned type=0; type<=Type::QUEEN; type++) {
+        if ((placers[type] != nullptr) != (typeTraits[type].cost != 0))
+            return false;
+    }
+    return true;
+}
+static_assert(placersMatchCosts(), "Every type the player can place needs a cost in typeTraits, and the other way around");
+
+Player::Player(GameWorld* world, sista::Coordinates coordinates) : Entity(world, coordinates, PLAYER_STYLE, Type::PLAYER), weapon(Type::BULLET), ammonitions(world->balance.startAmmonition), speed(world->balance.projectileSpeed) {}
+Player::Player() : Entity(nullptr, {0, 0}, PLAYER_STYLE, Type::PLAYER), weapon(Type::BULLET), ammonitions(START_AMMONITION) {}
+void Player::move(Direction direction) {
+    sista::Coordinates nextCoordinates = coordinates + directionOffset(direction);
+    if (world->field->isOutOfBounds(nextCoordinates) || !world->field->isFree(nextCoordinates) || nextCoordinates.x >= 30) {
+        return; // No complications, if you can't move there just pretend the command was never given
+    }
+    world->field->movePawn(this, nextCoordinates);
+    coordinates = nextCoordinates;
+}
+void Player::shoot(Direction direction) {
+    sista::Coordinates spawn = this->coordinates + directionOffset(direction);
+    if (!world->field->isFree(spawn)) {
+        return; // No complications, if you can't spawn something there just pretend the command was never given
+    }
+    if (world->player->ammonitions <= 0) {
+        world->emit(AMMO_EMPTY, this); // The frame loop rings the bell
+        return; // No complications, if you can't spawn something there just pretend the command was never given
+    }
+    Placer place = placers[weapon];
+    if (place == nullptr || world->player->ammonitions < typeTraits[weapon].cost)
+        return;
+    world->player->ammonitions -= typeTraits[weapon].cost;
+    world->emit(AMMO_CHANGED, this, ammonitions);
+    place(this, spawn, direction);
+}
+
+void Zombie::removeZombie(std::shared_ptr<Zombie> zombie) {
+    zombie->world->emit(ENTITY_KILLED, zombie.get());
+    zombie->world->zombies.erase(std::find(zombie->world->zombies.begin(), zombie->world->zombies.end(), zombie));
+    zombie->world->field->erasePawn(zombie.get());
+}
+void Zombie::removeZombie(Zombie* zombie) {
+    auto it = std::find_if(zombie->world->zombies.begin(), zombie->world->zombies.end(),
+        [zombie](const std::shared_ptr<Zombie>& z) { return z.get() == zombie; });
+    if (it != zombie->world->zombies.end()) {
+        zombie->world->emit(ENTITY_KILLED, zombie);
+        zombie->world->field->erasePawn(zombie);
+        zombie->world->zombies.erase(it);
+    }
+}
+Zombie::Zombie(GameWorld* world, sista::Coordinates coordinates) : Entity(world, coordinates, ZOMBIE_STYLE, Type::ZOMBIE) {}
+Zombie::Zombie() : Entity(nullptr, {0, 0}, ZOMBIE_STYLE, Type::ZOMBIE) {}
+void Zombie::move() { // Zombies mostly move vertically and stay defending the mother
+    sista::Coordinates nextCoordinates;
+    // The zombie may move towards the player if it's in the same row, but it may also move the other way
+    if (world->player->getCoordinates().y == coordinates.y) {
+        // Player.x is always < Zombie.x, so no need to check that
+        nextCoordinates = coordinates + directionOffset(Direction::LEFT);
+        // If the Zombie is too left, it will move right
+        if (coordinates.x < 30) {
+            nextCoordinates = coordinates + directionOffset(Direction::RIGHT);
+        }
+    } else {
+        if (world->rand() % 2 == 0) {
+            nextCoordinates = coordinates + directionOffset(Direction::DOWN);
+        } else {
+            nextCoordinates = coordinates + directionOffset(Direction::UP);
+        }
+    }
+    if (world->field->isFree(nextCoordinates)) {
+        world->field->movePawn(this, nextCoordinates);
+        coordinates = nextCoordinates;
+    }
+}
+void Zombie::shoot() {
+    sista::Coordinates spawn = coordinates + directionOffset(Direction::LEFT);
+    if (!world->field->isFree(spawn)) {
+        return; // No complications, if you can't spawn something there just pretend the command was never given
+    }
+    world->spawn<EnemyBullet>(spawn, Direction::LEFT);
+}
+
+Queen::Queen(GameWorld* world, sista::Coordinates coordinates) : Entity(world, coordinates, (StyleId)(QUEEN_STYLE + 9), Type::QUEEN), life(9) {}
+Queen::Queen() : Entity(nullptr, {0, 0}, (StyleId)(QUEEN_STYLE + 9), Type::QUEEN), life(9) {}
+void Queen::move() {
+    // Queen's movement is only vertical and it is always near the center of its side {10, 49}
+    if (world->rand() % 10 == 0) {
+        if (coordinates.y < 6) return;
+        sista::Coordinates nextCoordinates = coordinates + directionOffset(Direction::UP);
+        if (world->field->isFree(nextCoordinates)) {
+            world->field->movePawn(this, nextCoordinates);
+            coordinates = nextCoordinates;
+        }
+    } else if (world->rand() % 10 == 1) {
+        if (coordinates.y > 14) return;
+        sista::Coordinates nextCoordinates = coordinates + directionOffset(Direction::DOWN);
+        if (world->field->isFree(nextCoordinates)) {
+            world->field->movePawn(this, nextCoordinates);
+            coordinates = nextCoordinates;
+        }
+    }
+}
+void Queen::showLife() {
+    setStyle((StyleId)(QUEEN_STYLE + std::max(0, std::min(9, life))));
+}
+void Queen::damage() {
+    life--;
+    world->emit(QUEEN_DAMAGED, this, life); // Her look is refreshed by the frame loop
+    createWall();
+    if (life == 0)
+        world->finish(true);
+}
+void Queen::createWall() {
+    // First determine the length of the wall
+    unsigned short length = world->rand() % 3 + 3; // in range [3, 5]
+    // Then determine the position of the wall (the center of the wall is on the y coordinate of the queen)
+    unsigned short y = coordinates.y;
+    // Then search for an x coordinate which is free
+    unsigned short x = 48;
+    for (; x >= 30; x--) {
+        // We need to check all the cells in range {[y-length/2, y+1+length/2], x}
+        bool free = true;
+        for (unsigned short j=y-length/2; j<=y+1+length/2; j++) {
+            if (!world->field->isFree(j, x)) {
+                free = false;
+                break;
+            }
+        }
+        if (free) break;
+    }
+    if (x <= 30) return; // No free space to create the wall
+    // Now we can create the wall
+    for (unsigned short j=y-length/2; j<=y+1+length/2; j++)
+        world->spawn<Wall>(sista::Coordinates{j, x}, 1);
+}
+
+void Wall::removeWall(std::shared_ptr<Wall> wall) {
+    wall->world->emit(ENTITY_KILLED, wall.get());
+    wall->world->walls.erase(std::find(wall->world->walls.begin(), wall->world->walls.end(), wall));
+    wall->world->field->erasePawn(wall.get());
+}
+Wall::Wall(GameWorld* world, sista::Coordinates coordinates, short int strength) : Entity(world, coordinates, WALL_STYLE, Type::WALL), strength(strength) {}
+Wall::Wall() : Entity(nullptr, {0, 0}, WALL_STYLE, Type::WALL), strength(3) {}
+void Wall::destroy() {
+    strength = 0;
+    setStyle(DESTROYED_WALL_STYLE); // '@' indicates that the wall was destroyed
+    world->emit(WALL_DESTROYED, this); // The frame loop reprints it if it's still there at the end of the frame
+}
+
+void Mine::removeMine(std::shared_ptr<Mine> mine) {
+    mine->world->emit(ENTITY_KILLED, mine.get());
+    mine->world->mines.erase(std::find(mine->world->mines.begin(), mine->world->mines.end(), mine));
+    mine->world->field->erasePawn(mine.get());
+}
+Mine::Mine(GameWorld* world, sista::Coordinates coordinates) : Entity(world, coordinates, MINE_STYLE, Type::MINE) {}
+Mine::Mine() : Entity(nullptr, {0, 0}, MINE_STYLE, Type::MINE) {}
+bool Mine::checkTrigger() {
+    if (!hordeNearby())
+        return false;
+    trigger();
+    return true;
+}
+bool Mine::hordeNearby() const {
+    for (int j=-1; j<=1; j++) {
+        for (int i=-1; i<=1; i++) {
+            if (i == 0 && j == 0) continue;
+            sista::Coordinates nextCoordinates = coordinates + sista::Coordinates(j, i);
+            if (world->field->isOutOfBounds(nextCoordinates)) continue;
+            Entity* neighbor = (Entity*)world->field->getPawn(nextCoordinates);
+            if (neighbor == nullptr) {
+                continue;
+            } else if (typeTraits[neighbor->type].collision == HORDE) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+void Mine::trigger() {
+    setStyle(TRIGGERED_MINE_STYLE); // It explodes later in the same frame, nobody sees the new look
+}
+void Mine::explode() {
+    const int radius = typeTraits[Type::MINE].blastRadius;
+    for (int j=-radius; j<=radius; j++) {
+        for (int i=-radius; i<=radius; i++) {
+            if (i == 0 && j == 0) continue;
+            sista::Coordinates nextCoordinates = coordinates + sista::Coordinates(j, i);
+            if (world->field->isOutOfBounds(nextCoordinates)) {
+                continue;
+            }
+            Entity* neighbor = (Entity*)world->field->getPawn(nextCoordinates);
+            if (neighbor == nullptr) {
+                continue;
+            } else if (neighbor->type == Type::ZOMBIE) {
+                Zombie::removeZombie((Zombie*)neighbor);
+            } else if (neighbor->type == Type::WALKER) {
+                Walker::removeWalker((Walker*)neighbor);
+            } else if (neighbor->type == Type::ENEMYBULLET) {
+                EnemyBullet::removeEnemyBullet((EnemyBullet*)neighbor);
+            } else if (neighbor->type == Type::MINE) {
+                Mine* mine = (Mine*)neighbor;
+                mine->setStyle(TRIGGERED_MINE_STYLE);
+            } else if (neighbor->type == Type::CANNON) {
+                Cannon::removeCannon((Cannon*)neighbor);
+            } else if (neighbor->type == Type::QUEEN) {
+                ((Queen*)neighbor)->damage();
+            } else if (neighbor->type == Type::WALL) {
+                Wall* wall = (Wall*)neighbor;
+                int damage = world->rand() % 3 + 1;
+                if (wall->strength <= damage) {
+                    wall->destroy();
+                } else {
+                    wall->strength -= damage;
+                }
+            }
+        }
+    }
+}
+
+void Cannon::removeCannon(std::shared_ptr<Cannon> cannon) {
+    cannon->world->emit(ENTITY_KILLED, cannon.get());
+    cannon->world->cannons.erase(std::find(cannon->world->cannons.begin(), cannon->world->cannons.end(), cannon));
+    cannon->world->field->erasePawn(cannon.get());
+}
+void Cannon::removeCannon(Cannon* cannon) {
+    auto it = std::find_if(cannon->world->cannons.begin(), cannon->world->cannons.end(),
+        [cannon](const std::shared_ptr<Cannon>& c) { return c.get() == cannon; });
+    if (it != cannon->world->cannons.end()) {
+        cannon->world->emit(ENTITY_KILLED, cannon);
+        cannon->world->field->erasePawn(cannon);
+        cannon->world->cannons.erase(it);
+    }
+}
+Cannon::Cannon(GameWorld* world, sista::Coordinates coordinates, unsigned short period) : Entity(world, coordinates, CANNON_STYLE, Type::CANNON), distribution(1.0/period) {}
+Cannon::Cannon() : Entity(nullptr, {0, 0}, CANNON_STYLE, Type::CANNON), distribution(1.0/CANNON_FIRE_PERIOD) {}
+void Cannon::fire() {
+    sista::Coordinates spawn = coordinates + directionOffset(Direction::RIGHT);
+    if (!world->field->isFree(spawn)) {
+        return; // No complications, if you can't spawn something there just pretend the command was never given
+    }
+    if (world->player->ammonitions <= 0) {
+        return; // No complications, if you can't spawn something there just pretend the command was never given
+    }
+    world->player->ammonitions--;
+    world->emit(AMMO_CHANGED, world->player.get(), world->player->ammonitions);
+    world->spawn<Bullet>(spawn, Direction::RIGHT);
+}
+void Cannon::recomputeDistribution(const FrameVector<FrameVector<unsigned short>>& workersPositions) {
+    // Count the consecutive workers in the same row right back to the cannon
+    unsigned short count = 0;
+    for (unsigned short i=coordinates.x-1; i>=0; i--) {
+        if (std::find(workersPositions[coordinates.y].begin(), workersPositions[coordinates.y].end(), i) != workersPositions[coordinates.y].end()) {
+            count++;
+        } else {
+            break; // If there's no worker in the position, then there's no need to keep counting
+        }
+    }
+    distribution = std::bernoulli_distribution(1.0/((float)world->balance.cannonFirePeriod - std::min(1.4*count, world->balance.cannonFirePeriod - 1.0)));
+}
+
+void Worker::removeWorker(std::shared_ptr<Worker> worker) {
+    worker->world->emit(ENTITY_KILLED, worker.get());
+    worker->world->workers.erase(std::find(worker->world->workers.begin(), worker->world->workers.end(), worker));
+    worker->world->field->erasePawn(worker.get());
+}
+void Worker::removeWorker(Worker* worker) {
+    auto it = std::find_if(worker->world->workers.begin(), worker->world->workers.end(),
+        [worker](const std::shared_ptr<Worker>& other) { return other.get() == worker; });
+    if (it != worker->world->workers.end()) {
+        worker->world->emit(ENTITY_KILLED, worker);
+        worker->world->field->erasePawn(worker);
+        worker->world->workers.erase(it); // Last, it can destroy the worker
+    }
+}
+Worker::Worker(GameWorld* world, sista::Coordinates coordinates) : Entity(world, coordinates, WORKER_STYLE, Type::WORKER) {}
+Worker::Worker() : Entity(nullptr, {0, 0}, WORKER_STYLE, Type::WORKER) {}
+void Worker::produce() {
+    world->player->ammonitions++;
+    world->emit(AMMO_CHANGED, world->player.get(), world->player->ammonitions);
+}
+
+void ArmedWorker::removeArmedWorker(std::shared_ptr<ArmedWorker> worker) {
+    worker->world->emit(ENTITY_KILLED, worker.get());
+    worker->world->armedWorkers.erase(std::find(worker->world->armedWorkers.begin(), worker->world->armedWorkers.end(), worker));
+    worker->world->field->erasePawn(worker.get());
+}
+void ArmedWorker::removeArmedWorker(ArmedWorker* worker) {
+    auto it = std::find_if(worker->world->armedWorkers.begin(), worker->world->armedWorkers.end(),
+        [worker](const std::shared_ptr<ArmedWorker>& other) { return other.get() == worker; });
+    if (it != worker->world->armedWorkers.end()) {
+        worker->world->emit(ENTITY_KILLED, worker);
+        worker->world->field->erasePawn(worker);
+        worker->world->armedWorkers.erase(it); // Last, it can destroy the worker
+    }
+}
+ArmedWorker::ArmedWorker(GameWorld* world, sista::Coordinates coordinates) : Entity(world, coordinates, ARMED_WORKER_STYLE, Type::ARMED_WORKER) {}
+ArmedWorker::ArmedWorker() : Entity(nullptr, {0, 0}, ARMED_WORKER_STYLE, Type::ARMED_WORKER) {}
+void ArmedWorker::produce() {
+    world->player->ammonitions++;
+    world->emit(AMMO_CHANGED, world->player.get(), world->player->ammonitions);
+}
+void ArmedWorker::dodgeIfNeeded() {
+    if (world->lanes.framesToImpact(coordinates, Type::ENEMYBULLET) > ARMED_WORKER_REACTION)
+        return;
+    sista::Coordinates right = this->coordinates + directionOffset(Direction::RIGHT);
+    if (!world->field->isOutOfBounds(right) && world->field->isFree(right)) {
+        world->spawn<Wall>(right, typeTraits[Type::WALL].strength);
+    } else {
+        // If we can't place the wall, just give that up
+    }
+
+    sista::Coordinates destination = this->coordinates + directionOffset(Direction::UP);
+    Direction moved = Direction::UP;
+    if (world->field->isFree(destination)) {
+        world->field->movePawn(this, destination);
+    } else {
+        destination = this->coordinates + directionOffset(Direction::DOWN);
+        moved = Direction::DOWN;
+        if (world->field->isFree(destination)) {
+            world->field->movePawn(this, destination);
+        } else {
+            return;
+        }
+    }
+
+    world->spawn<Bullet>(this->coordinates + directionOffset(Direction::RIGHT), Direction::RIGHT);
+
+    destination = this->coordinates + directionOffset(directionTraits[moved].opposite);
+    if (world->field->isFree(destination)) {
+        world->field->movePawn(this, destination);
+    }
+}
+
+void Bomber::removeBomber(std::shared_ptr<Bomber> bomber) {
+    bomber->world->emit(ENTITY_KILLED, bomber.get());
+    bomber->world->bombers.erase(std::find(bomber->world->bombers.begin(), bomber->world->bombers.end(), bomber));
+    bomber->world->field->erasePawn(bomber.get());
+}
+void Bomber::removeBomber(Bomber* bomber) {
+    auto it = std::find_if(bomber->world->bombers.begin(), bomber->world->bombers.end(),
+        [bomber](const std::shared_ptr<Bomber>& b) { return b.get() == bomber; });
+    if (it != bomber->world->bombers.end()) {
+        bomber->world->emit(ENTITY_KILLED, bomber);
+        bomber->world->field->erasePawn(bomber);
+        bomber->world->bombers.erase(it); // Last, it can destroy the bomber
+    }
+}
+Bomber::Bomber(GameWorld* world, sista::Coordinates coordinates) : Entity(world, coordinates, BOMBER_STYLE, Type::BOMBER) {}
+Bomber::Bomber() : Entity(nullptr, {0, 0}, BOMBER_STYLE, Type::BOMBER) {}
+void Bomber::move() {
+    sista::Coordinates nextCoordinates = coordinates + directionOffset(Direction::RIGHT);
+    if (world->field->isOutOfBounds(nextCoordinates)) {
+        if (coordinates.x == 49) {
+            this->explode();
+        }
+        this->exploded = true; // Mark for removal
+        return;
+    }
+    Entity* neighbor = (Entity*)world->field->getPawn(nextCoordinates);
+    if (neighbor == nullptr) {
+        world->field->movePawn((Pawn*)this, nextCoordinates);
+        coordinates = nextCoordinates;
+        return;
+    } else if (neighbor->type == Type::WALL) {
+        ((Wall*)neighbor)->destroy();
+        explode();
+    } else if (neighbor->type == Type::PLAYER) {
+        return; // The player keeps the bomber in place
+    } else if (neighbor->type == Type::BULLET) {
+        ((Bullet*)neighbor)->collided = true;
+    } else if (neighbor->type == Type::ENEMYBULLET) {
+        ((EnemyBullet*)neighbor)->collided = true;
+    } else if (neighbor->type == Type::MINE) {
+        Mine* mine = (Mine*)neighbor;
+        mine->setStyle(TRIGGERED_MINE_STYLE);
+    } else if (typeTraits[neighbor->type].collision == HORDE) {
+        explode();
+    } else if (neighbor->type == Type::QUEEN) {
+        ((Queen*)neighbor)->damage();
+    } else if (neighbor->type == Type::BOMBER) {
+        return;
+    }
+    this->exploded = true; // Mark for removal
+}
+void Bomber::explode() {
+    const int radius = typeTraits[Type::BOMBER].blastRadius;
+    for (int j=-radius; j<=radius; j++) {
+        for (int i=-radius; i<=radius; i++) {
+            if (i == 0 && j == 0) continue;
+            sista::Coordinates nextCoordinates = coordinates + sista::Coordinates(j, i);
+            if (world->field->isOutOfBounds(nextCoordinates)) {
+                continue;
+            }
+            Entity* neighbor = (Entity*)world->field->getPawn(nextCoordinates);
+            if (neighbor == nullptr) {
+                continue;
+            } else if (neighbor->type == Type::ZOMBIE) {
+                Zombie::removeZombie((Zombie*)neighbor);
+            } else if (neighbor->type == Type::WALKER) {
+                Walker::removeWalker((Walker*)neighbor);
+            } else if (neighbor->type == Type::MINE) {
+                Mine* mine = (Mine*)neighbor;
+                mine->setStyle(TRIGGERED_MINE_STYLE);
+            } else if (neighbor->type == Type::CANNON) {
+                Cannon::removeCannon((Cannon*)neighbor);
+            } else if (neighbor->type == Type::QUEEN) {
+                ((Queen*)neighbor)->damage();
+            } else if (neighbor->type == Type::WALL) {
+                Wall* wall = (Wall*)neighbor;
+                int damage = world->rand() % 3 + 1;
+                if (wall->strength <= damage) {
+                    wall->destroy();
+                } else {
+                    wall->strength -= damage;
+                }
+            } else if (neighbor->type == Type::BOMBER) {
+                continue;
+            }
+        }
+    }
+}
+
+void Walker::removeWalker(std::shared_ptr<Walker> walker) {
+    walker->world->emit(ENTITY_KILLED, walker.get());
+    walker->world->walkers.erase(std::find(walker->world->walkers.begin(), walker->world->walkers.end(), walker));
+    walker->world->field->erasePawn(walker.get());
+}
+void Walker::removeWalker(Walker* walker) {
+    auto it = std::find_if(walker->world->walkers.begin(), walker->world->walkers.end(),
+        [walker](const std::shared_ptr<Walker>& w) { return w.get() == walker; });
+    GameWorld* world = walker->world;
+    world->field->erasePawn(walker);
+    if (it != world->walkers.end()) {
+        world->emit(ENTITY_KILLED, walker);
+        world->walkers.erase(it); // Last, it can destroy the walker
+    }
+}
+Walker::Walker(GameWorld* world, sista::Coordinates coordinates) : Entity(world, coordinates, WALKER_STYLE, Type::WALKER) {}
+Walker::Walker() : Entity(nullptr, {0, 0}, WALKER_STYLE, Type::WALKER) {}
+void Walker::move() { // Walkers mostly move horizontally because they only rarely shoot bullets and they walk slowly towards the left side
+    Direction direction_ = Direction::LEFT;
+    if (world->balance.walkerPathfinding)
+        direction_ = world->flowField.next(coordinates);
+    else if (world->rand() % 30 == 0)
+        direction_ = Direction::DOWN;
+    sista::Coordinates nextCoordinates = coordinates + directionOffset(direction_);
+    if (world->field->isOutOfBounds(nextCoordinates)) {
+        if (coordinates.x == 0) { // Touchdown, the player loses all the ammonitions
+            world->player->ammonitions = 0;
+            world->emit(AMMO_CHANGED, world->player.get(), 0);
+            this->explode();
+            this->exploded = true; // Mark for removal
+            return;
+        } else { // Touched bottom limit, we can use pacman effect which clearly can be used by walkers
+            try {
+                world->field->movePawnBy(this, directionOffset(Direction::DOWN), sista::Effect::PACMAN);
+            } catch (const std::exception& e) {
+                // Nothing happens, but trying to apply manually the pacman effect and hitting something on the other side would be awkward
+            }
+            return;
+        }
+    }
+    Entity* neighbor = (Entity*)world->field->getPawn(nextCoordinates);
+    if (neighbor == nullptr) {
+        world->field->movePawn((Pawn*)this, nextCoordinates);
+        coordinates = nextCoordinates;
+        return;
+    } else if (neighbor->type == Type::PLAYER) {
+        world->finish(false);
+    } else if (neighbor->type == Type::BULLET) {
+        Bullet::removeBullet((Bullet*)neighbor);
+        this->exploded = true; // Mark for removal
+    } else if (neighbor->type == Type::WALL) {
+        Wall* wall = (Wall*)neighbor;
+        if (wall->strength == 0) {
+            return;
+        }
+        wall->strength--;
+        if (wall->strength == 0)
+            wall->destroy();
+    } else if (neighbor->type == Type::MINE) {
+        Mine* mine = (Mine*)neighbor;
+        mine->setStyle(TRIGGERED_MINE_STYLE);
+    } else if (neighbor->type == Type::CANNON) {
+        Cannon::removeCannon((Cannon*)neighbor);
+    } else if (neighbor->type == Type::WORKER) {
+        Worker::removeWorker((Worker*)neighbor);
+    } else if (neighbor->type == Type::ARMED_WORKER) {
+        ArmedWorker::removeArmedWorker((ArmedWorker*)neighbor);
+    }
+}
+void Walker::explode() {
+    const int radius = typeTraits[Type::WALKER].blastRadius;
+    for (int j=-radius; j<=radius; j++) {
+        for (int i=-radius; i<=radius; i++) {
+            if (i == 0 && j == 0) continue;
+            sista::Coordinates nextCoordinates = coordinates + sista::Coordinates(j, i);
+            if (world->field->isOutOfBounds(nextCoordinates)) {
+                continue;
+            }
+            Entity* neighbor = (Entity*)world->field->getPawn(nextCoordinates);
+            if (neighbor == nullptr) {
+                continue;
+            } else if (neighbor->type == Type::ZOMBIE) {
+                Zombie::removeZombie((Zombie*)neighbor);
+            } else if (neighbor->type == Type::WALKER) {
+                Walker::removeWalker((Walker*)neighbor);
+            } else if (neighbor->type == Type::ENEMYBULLET) {
+                EnemyBullet::removeEnemyBullet((EnemyBullet*)neighbor);
+            } else if (neighbor->type == Type::MINE) {
+                Mine* mine = (Mine*)neighbor;
+                mine->setStyle(TRIGGERED_MINE_STYLE);
+            } else if (neighbor->type == Type::CANNON) {
+                Cannon::removeCannon((Cannon*)neighbor);
+            } else if (neighbor->type == Type::WALL) {
+                Wall* wall = (Wall*)neighbor;
+                int damage = world->rand() % 3 + 1;
+                if (wall->strength <= damage) {
+                    wall->destroy();
+                } else {
+                    wall->strength -= damage;
+                }
+            } else if (neighbor->type == Type::WORKER) {
+                Worker::removeWorker((Worker*)neighbor);
+            } else if (neighbor->type == Type::ARMED_WORKER) {
+                ArmedWorker::removeArmedWorker((ArmedWorker*)neighbor);
+            }
+        }
+    }
+}
+
+void removeNullptrs(std::vector<std::shared_ptr<Entity>>& entities) {
+    std::size_t before = entities.size();
+    entities.erase(
+        std::remove(entities.begin(), entities.end(), nullptr),
+        entities.end()
+    );
+    trace(TRACE_DEBUG, NULLPTRS_REMOVED, TRACE_NO_TYPE, 0, 0, before - entities.size());
+}
@@ -0,0 +1,133 @@
+#include "jobs.hpp"
+#include <algorithm>
+
+std::size_t JobGraph::chunksOf(unsigned phase) const {
+    std::size_t chunks = (phases[phase].count + phases[phase].grain - 1) / phases[phase].grain;
+    return chunks == 0 ? 1 : chunks; // An empty phase still has to finish to start its dependents
+}
+
+void JobGraph::runInline() {
+    for (unsigned phase=0; phase<size; phase++) // Phases only depend on phases added before them
+        phases[phase].call(phases[phase].body, 0, phases[phase].count);
+}
+
+bool JobGraph::parallel() const {
+    for (unsigned phase=0; phase<size; phase++)
+        if (chunksOf(phase) > 1)
+            return true;
+    return false;
+}
+
+JobSystem::JobSystem(unsigned threads) {
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i=0; i<threads; i++)
+        queues.push_back(std::make_unique<Queue>());
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+void JobSystem::run(JobGraph& graph) {
+    if (queues.size() == 1 || !graph.parallel()) {
+        graph.runInline();
+        return;
+    }
+    if (workers.empty())
+        for (unsigned i=1; i<queues.size(); i++)
+            workers.emplace_back(&JobSystem::work, this, i);
+    graph.unfinished.store(graph.size, std::memory_order_relaxed);
+    for (unsigned phase=0; phase<graph.size; phase++)
+        if (graph.phases[phase].waiting.load(std::memory_order_relaxed) == 0)
+            schedule(graph, phase, 0);
+    // The caller works until the last phase is over, the jobs left to the other threads are short
+    while (graph.unfinished.load(std::memory_order_acquire) > 0) {
+        Job job;
+        if (take(0, job))
+            execute(job, 0);
+        else
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::schedule(JobGraph& graph, unsigned phase, unsigned queue) {
+    JobGraph::Phase& scheduled = graph.phases[phase];
+    std::size_t chunks = graph.chunksOf(phase);
+    scheduled.chunks.store(chunks, std::memory_order_relaxed);
+    std::size_t pushed = 0;
+    {
+        Queue& owned = *queues[queue];
+        std::lock_guard<std::mutex> lock(owned.mutex);
+        for (; pushed<chunks && owned.tail - owned.head < JOBS_QUEUE; pushed++) {
+            std::size_t begin = pushed * scheduled.grain;
+            owned.jobs[owned.tail++ % JOBS_QUEUE] = {&graph, phase, begin, std::min(begin + scheduled.grain, scheduled.count)};
+        }
+        queued.fetch_add(pushed, std::memory_order_release);
+    }
+    if (pushed > 0) {
+        { std::lock_guard<std::mutex> lock(sleepMutex); } // A worker between its check of queued and its wait can't miss the notification
+        wakeUp.notify_all();
+    }
+    for (; pushed<chunks; pushed++) { // The queue is full
+        std::size_t begin = pushed * scheduled.grain;
+        execute({&graph, phase, begin, std::min(begin + scheduled.grain, scheduled.count)}, queue);
+    }
+}
+
+bool JobSystem::take(unsigned queue, Job& job) {
+    if (queued.load(std::memory_order_acquire) == 0)
+        return false;
+    {
+        Queue& owned = *queues[queue];
+        std::lock_guard<std::mutex> lock(owned.mutex);
+        if (owned.tail != owned.head) {
+            job = owned.jobs[--owned.tail % JOBS_QUEUE];
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    for (unsigned i=1; i<queues.size(); i++) {
+        Queue& victim = *queues[(queue + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tail != victim.head) {
+            job = victim.jobs[victim.head++ % JOBS_QUEUE];
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::execute(const Job& job, unsigned queue) {
+    JobGraph& graph = *job.graph;
+    JobGraph::Phase& phase = graph.phases[job.phase];
+    phase.call(phase.body, job.begin, job.end);
+    if (phase.chunks.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+    // Last chunk of the phase: its dependents are scheduled before the phase counts as over, so run() can't return early
+    for (unsigned i=0; i<phase.dependents; i++)
+        if (graph.phases[phase.dependent[i]].waiting.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            schedule(graph, phase.dependent[i], queue);
+    graph.unfinished.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void JobSystem::work(unsigned queue) {
+    while (true) {
+        Job job;
+        if (take(queue, job)) {
+            execute(job, queue);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this]() { return stopping || queued.load(std::memory_order_acquire) > 0; });
+        if (stopping)
+            return;
+    }
+}
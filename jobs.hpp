@@ -0,0 +1,115 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define JOBS_PHASES 16 // Phases a JobGraph holds
+#define JOBS_QUEUE 1024 // Jobs the queue of a thread holds, a job that doesn't fit runs right away on the thread that scheduled it
+#define JOBS_GRAIN 64 // Entities a job of update() handles, smaller lists are handled by a single job
+
+// The phases of a frame that can run at the same time: each phase calls its body over [0, count) in chunks of grain
+// items, body(begin, end), once every phase it depends on is over. Bodies write their results at the index of the item
+// and the caller applies them in order after the run, so the frame doesn't depend on how the chunks were spread.
+// A graph lives on the stack of the frame, runs once and doesn't allocate, bodies must outlive the run, so they are
+// named lambdas of the frame: a temporary doesn't compile.
+class JobGraph {
+public:
+    // Adds a phase that starts after the phases in after (indexes returned by earlier calls), returns its index
+    template <typename F>
+    unsigned add(std::size_t count, std::size_t grain, const F& body, std::initializer_list<unsigned> after = {}) {
+        assert(size < JOBS_PHASES && "a JobGraph holds JOBS_PHASES phases");
+        Phase& phase = phases[size];
+        phase.call = &invoke<F>;
+        phase.body = &body;
+        phase.count = count;
+        phase.grain = grain == 0 ? 1 : grain;
+        phase.dependents = 0;
+        phase.waiting.store(after.size(), std::memory_order_relaxed);
+        for (unsigned before : after) {
+            assert(before < size && "a phase can only start after phases added before it");
+            assert(phases[before].dependents < JOBS_PHASES && "a phase has JOBS_PHASES dependents at most");
+            phases[before].dependent[phases[before].dependents++] = size;
+        }
+        return size++;
+    }
+    // The graph keeps a pointer to the body, which would dangle once the temporary is destroyed
+    template <typename F>
+    unsigned add(std::size_t, std::size_t, const F&&, std::initializer_list<unsigned> = {}) = delete;
+    void runInline(); // Runs every phase on the calling thread, in the order they were added
+    bool parallel() const; // Whether a phase has more than one chunk, otherwise there is nothing to spread
+
+private:
+    friend class JobSystem;
+    struct Phase {
+        void (*call)(const void*, std::size_t, std::size_t);
+        const void* body;
+        std::size_t count, grain;
+        unsigned dependent[JOBS_PHASES]; // Phases waiting for this one
+        unsigned dependents;
+        std::atomic<unsigned> waiting; // Phases this one still waits for
+        std::atomic<std::size_t> chunks; // Chunks not done yet
+    };
+    Phase phases[JOBS_PHASES];
+    unsigned size = 0;
+    std::atomic<unsigned> unfinished{0}; // Phases not done yet
+
+    template <typename F>
+    static void invoke(const void* body, std::size_t begin, std::size_t end) {
+        (*(const F*)body)(begin, end);
+    }
+    std::size_t chunksOf(unsigned phase) const;
+};
+
+// A small work-stealing thread pool: every thread has its own queue, takes its newest job first and, when it is empty,
+// steals the oldest job of another thread. The thread calling run() works too, on queue 0, so a JobSystem of one
+// thread runs everything inline. Workers sleep while no job is queued, and are only started by the first graph
+// that has a phase to split: a game whose phases all fit in one job never starts them.
+class JobSystem {
+public:
+    explicit JobSystem(unsigned threads = 0); // Counting the caller of run(), 0 for one per core
+    ~JobSystem();
+
+    unsigned threads() const { return queues.size(); }
+    bool started() const { return !workers.empty(); } // Whether a graph had something to split and the workers run
+    // Runs the graph and returns once every phase is over, one caller at a time. Graphs where no phase has more
+    // than one chunk run inline: waking the workers would cost more than they save.
+    void run(JobGraph&);
+
+private:
+    struct Job {
+        JobGraph* graph;
+        unsigned phase;
+        std::size_t begin, end;
+    };
+    // Ring of jobs, the owner pushes and pops at the tail, thieves take at the head
+    struct Queue {
+        std::mutex mutex;
+        Job jobs[JOBS_QUEUE];
+        std::size_t head = 0, tail = 0;
+    };
+    std::vector<std::unique_ptr<Queue>> queues; // queues[0] belongs to the caller of run()
+    std::vector<std::thread> workers;
+    std::atomic<std::size_t> queued{0};
+    bool stopping = false; // Guarded by sleepMutex
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+
+    void schedule(JobGraph&, unsigned phase, unsigned queue); // Splits the phase in chunks on the queue
+    bool take(unsigned queue, Job&);
+    void execute(const Job&, unsigned queue);
+    void work(unsigned queue);
+};
+
+// Runs the graph on the JobSystem, or inline without one
+inline void runJobs(JobSystem* jobs, JobGraph& graph) {
+    if (jobs != nullptr)
+        jobs->run(graph);
+    else
+        graph.runInline();
+}
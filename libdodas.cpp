@@ -0,0 +1,121 @@
+#include "libdodas.h"
+#include "dodas.hpp"
+#include <cstring>
+#include <iostream>
+#include <new>
+
+static_assert(DODAS_WIDTH == WIDTH && DODAS_HEIGHT == HEIGHT, "libdodas.h must match the field of dodas.hpp");
+static_assert(DODAS_PLANES == Type::QUEEN + 1, "libdodas.h must have one plane per Type");
+
+struct DodasWorld {
+    GameWorld world;
+    bool hardcore;
+    unsigned frame = 0;
+
+    DodasWorld(unsigned seed, bool hardcore) : world(seed), hardcore(hardcore) {}
+};
+
+// std::cout is discarded while at least one thread is inside the API, the host gets it back afterwards
+class SilentScope {
+public:
+    SilentScope() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (users++ == 0)
+            previous = std::cout.rdbuf(&nullBuffer);
+    }
+    ~SilentScope() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--users == 0)
+            std::cout.rdbuf(previous);
+    }
+
+private:
+    static std::mutex mutex;
+    static unsigned users;
+    static std::streambuf* previous;
+    static NullBuffer nullBuffer;
+};
+std::mutex SilentScope::mutex;
+unsigned SilentScope::users = 0;
+std::streambuf* SilentScope::previous = nullptr;
+NullBuffer SilentScope::nullBuffer;
+
+static void act(GameWorld& world, uint8_t action) {
+    static const Type weapons[] = {Type::BULLET, Type::MINE, Type::CANNON, Type::BOMBER, Type::WORKER, Type::ARMED_WORKER, Type::WALL};
+    if (action >= DODAS_MOVE_UP && action <= DODAS_MOVE_LEFT) {
+        world.player->move((Direction)(action - DODAS_MOVE_UP));
+    } else if (action >= DODAS_SHOOT_UP && action <= DODAS_SHOOT_LEFT) {
+        world.player->shoot((Direction)(action - DODAS_SHOOT_UP));
+    } else if (action >= DODAS_SELECT_BULLET && action <= DODAS_SELECT_WALL) {
+        world.player->weapon = weapons[action - DODAS_SELECT_BULLET];
+    } // DODAS_NOOP and unknown actions let the player wait
+}
+
+extern "C" {
+
+DodasWorld* dodas_create(unsigned seed, int hardcore) {
+    SilentScope silent;
+    DodasWorld* handle = new (std::nothrow) DodasWorld(seed, hardcore != 0);
+    if (handle == nullptr)
+        return nullptr;
+    handle->world.populate();
+    return handle;
+}
+
+void dodas_destroy(DodasWorld* handle) {
+    SilentScope silent;
+    delete handle;
+}
+
+void dodas_reset(DodasWorld* handle, unsigned seed) {
+    SilentScope silent;
+    GameWorld& world = handle->world;
+    world.clear();
+    world.rng.seed(seed);
+    world.paused = false;
+    world.populate();
+    handle->frame = 0;
+}
+
+void dodas_fork(const DodasWorld* from, DodasWorld* into) {
+    SilentScope silent;
+    from->world.fork(into->world);
+    into->hardcore = from->hardcore;
+    into->frame = from->frame;
+}
+
+size_t dodas_step(DodasWorld* const* worlds, const uint8_t* actions, size_t count, DodasObservation* observations) {
+    SilentScope silent;
+    size_t done = 0;
+    for (size_t j=0; j<count; j++) {
+        DodasWorld* handle = worlds[j];
+        if (!handle->world.end) {
+            act(handle->world, actions[j]);
+            handle->world.update(handle->frame++, handle->hardcore);
+        }
+        done += handle->world.end;
+        if (observations != nullptr)
+            dodas_observe(handle, &observations[j]);
+    }
+    return done;
+}
+
+void dodas_observe(const DodasWorld* handle, DodasObservation* observation) {
+    const GameWorld& world = handle->world;
+    std::memset(observation->planes, 0, sizeof(observation->planes));
+    for (unsigned short y=0; y<HEIGHT; y++) {
+        for (unsigned short x=0; x<WIDTH; x++) {
+            Entity* entity = (Entity*)world.field->getPawn(y, x);
+            if (entity != nullptr)
+                observation->planes[entity->type][y][x] = 1;
+        }
+    }
+    observation->ammonitions = world.player->ammonitions;
+    observation->life = world.queen->life;
+    observation->frame = handle->frame;
+    observation->weapon = world.player->weapon;
+    observation->done = world.end;
+    observation->won = world.queen->life <= 0;
+}
+
+}
@@ -0,0 +1,77 @@
+/* C API of the dodas engine, for programs that drive many games without a terminal (bots, training loops, tests)
+ *
+ *  DodasWorld* worlds[64];
+ *  for (unsigned j=0; j<64; j++) worlds[j] = dodas_create(j, 0);
+ *  while (...) {
+ *      fill actions[64];
+ *      dodas_step(worlds, actions, 64, observations);
+ *      for each observation with done set: dodas_reset(worlds[j], newSeed);
+ *  }
+ *
+ * A world must only be used by one thread at a time, different worlds can be stepped concurrently.
+ * The engine renders through Sista on std::cout: while a call of this API is running std::cout is discarded.
+ */
+#ifndef LIBDODAS_H
+#define LIBDODAS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DODAS_WIDTH 50
+#define DODAS_HEIGHT 20
+#define DODAS_PLANES 12 /* One plane per entity type, in the order of the Type enum of dodas.hpp */
+
+/* The same actions a human can give through the input thread */
+enum DodasAction {
+    DODAS_NOOP = 0,
+    DODAS_MOVE_UP, DODAS_MOVE_RIGHT, DODAS_MOVE_DOWN, DODAS_MOVE_LEFT,
+    DODAS_SHOOT_UP, DODAS_SHOOT_RIGHT, DODAS_SHOOT_DOWN, DODAS_SHOOT_LEFT,
+    DODAS_SELECT_BULLET, DODAS_SELECT_MINE, DODAS_SELECT_CANNON, DODAS_SELECT_BOMBER,
+    DODAS_SELECT_WORKER, DODAS_SELECT_ARMED_WORKER, DODAS_SELECT_WALL,
+    DODAS_ACTIONS
+};
+
+enum DodasPlane {
+    DODAS_PLANE_PLAYER, DODAS_PLANE_WORKER, DODAS_PLANE_ARMED_WORKER, DODAS_PLANE_CANNON,
+    DODAS_PLANE_BOMBER, DODAS_PLANE_BULLET, DODAS_PLANE_MINE, DODAS_PLANE_WALL,
+    DODAS_PLANE_ZOMBIE, DODAS_PLANE_WALKER, DODAS_PLANE_ENEMYBULLET, DODAS_PLANE_QUEEN
+};
+
+typedef struct DodasObservation {
+    uint8_t planes[DODAS_PLANES][DODAS_HEIGHT][DODAS_WIDTH]; /* 1 where an entity of that type stands, 0 elsewhere */
+    int32_t ammonitions;
+    int32_t life; /* Life of the queen */
+    uint32_t frame; /* Frames simulated since the last reset */
+    uint8_t weapon; /* Selected weapon, as a plane index */
+    uint8_t done; /* The game is over, further steps are ignored until dodas_reset() */
+    uint8_t won; /* The queen has been killed */
+} DodasObservation;
+
+typedef struct DodasWorld DodasWorld;
+
+/* Returns a populated world ready for the first step, or NULL on allocation failure */
+DodasWorld* dodas_create(unsigned seed, int hardcore);
+void dodas_destroy(DodasWorld*);
+/* Starts a new game in the same world, with the same hardcore setting */
+void dodas_reset(DodasWorld*, unsigned seed);
+
+/* Makes into an exact copy of from (game, frame, hardcore setting) that plays on identically, for lookahead searches:
+ * fork a world, step the copy, fork again. Forking over and over into the same world doesn't allocate.
+ * Neither world may be in use by another thread during the call. */
+void dodas_fork(const DodasWorld* from, DodasWorld* into);
+
+/* Applies actions[j] and simulates one frame of worlds[j], for every j < count.
+ * If observations isn't NULL, observations[j] receives the state of worlds[j] after the frame.
+ * Returns the number of worlds whose game is over. */
+size_t dodas_step(DodasWorld* const* worlds, const uint8_t* actions, size_t count, DodasObservation* observations);
+void dodas_observe(const DodasWorld*, DodasObservation*);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
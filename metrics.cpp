@@ -0,0 +1,205 @@
+#include "metrics.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#ifndef _WIN32
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+std::string defaultMetricsPath() {
+    char path[64];
+    #ifdef _WIN32
+        snprintf(path, sizeof(path), METRICS_SOCKET, 0);
+    #else
+        snprintf(path, sizeof(path), METRICS_SOCKET, (int)getpid());
+    #endif
+    return path;
+}
+
+void countEntities(const GameWorld& world, FrameSample& sample) {
+    for (unsigned type=0; type<=Type::QUEEN; type++)
+        sample.entities[type] = world.entityCount((Type)type);
+}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+void MetricsServer::publish(const FrameSample& sample) {
+    unsigned long long position = head.load(std::memory_order_relaxed);
+    if (position - tail.load(std::memory_order_acquire) == METRICS_RING) {
+        dropped.fetch_add(1, std::memory_order_relaxed); // The metrics thread is late, losing a sample is better than waiting
+        return;
+    }
+    ring[position % METRICS_RING] = sample;
+    head.store(position + 1, std::memory_order_release);
+}
+
+void MetricsServer::drain() {
+    unsigned long long position = tail.load(std::memory_order_relaxed);
+    unsigned long long end = head.load(std::memory_order_acquire);
+    for (; position != end; position++) {
+        const FrameSample& sample = ring[position % METRICS_RING];
+        window[frames % METRICS_WINDOW] = sample;
+        frames++;
+        allocations += sample.allocations;
+        outputBytes += sample.outputBytes;
+        for (unsigned kind=0; kind<GAME_EVENT_KINDS; kind++)
+            events[kind] += sample.events[kind];
+    }
+    tail.store(position, std::memory_order_release);
+}
+
+std::string MetricsServer::format() {
+    std::size_t count = std::min<unsigned long long>(frames, METRICS_WINDOW);
+    const FrameSample* newest = frames > 0 ? &window[(frames - 1) % METRICS_WINDOW] : nullptr;
+    const FrameSample* oldest = frames > 0 ? &window[(frames - count) % METRICS_WINDOW] : nullptr;
+
+    std::vector<double> durations;
+    durations.reserve(count);
+    double windowAllocations = 0, windowOutput = 0, sum = 0;
+    for (std::size_t j=0; j<count; j++) {
+        const FrameSample& sample = window[(frames - count + j) % METRICS_WINDOW];
+        durations.push_back(std::chrono::duration<double>(sample.duration).count());
+        sum += durations.back();
+        windowAllocations += sample.allocations;
+        windowOutput += sample.outputBytes;
+    }
+    std::sort(durations.begin(), durations.end());
+    double tps = 0;
+    if (count > 1) {
+        double seconds = std::chrono::duration<double>(newest->end - oldest->end).count();
+        if (seconds > 0)
+            tps = (count - 1) / seconds;
+    }
+
+    std::ostringstream text;
+    text << "# HELP dodas_frame Frame counter of the game\n# TYPE dodas_frame gauge\n";
+    text << "dodas_frame " << (newest ? newest->frame : 0) << '\n';
+    text << "# HELP dodas_tps Frames per second achieved over the last " << count << " frames\n# TYPE dodas_tps gauge\n";
+    text << "dodas_tps " << tps << '\n';
+    text << "# HELP dodas_frame_seconds Simulation and rendering time of the last " << count << " frames\n";
+    text << "# TYPE dodas_frame_seconds summary\n";
+    for (double quantile : {0.5, 0.9, 0.99, 1.0}) {
+        double value = count > 0 ? durations[std::min(count - 1, (std::size_t)(quantile * count))] : 0;
+        text << "dodas_frame_seconds{quantile=\"" << quantile << "\"} " << value << '\n';
+    }
+    text << "dodas_frame_seconds_sum " << sum << '\n';
+    text << "dodas_frame_seconds_count " << count << '\n';
+    text << "# HELP dodas_entities Alive entities of each type\n# TYPE dodas_entities gauge\n";
+    for (unsigned type=0; type<=Type::QUEEN; type++)
+        text << "dodas_entities{type=\"" << typeNames[type] << "\"} " << (newest ? newest->entities[type] : 0) << '\n';
+    text << "# HELP dodas_allocations_per_frame Heap allocations per frame over the last " << count << " frames\n";
+    text << "# TYPE dodas_allocations_per_frame gauge\n";
+    text << "dodas_allocations_per_frame " << (count ? windowAllocations / count : 0) << '\n';
+    text << "# HELP dodas_allocations_total Heap allocations during the frames\n# TYPE dodas_allocations_total counter\n";
+    text << "dodas_allocations_total " << allocations << '\n';
+    text << "# HELP dodas_output_bytes_per_frame Bytes printed per frame over the last " << count << " frames\n";
+    text << "# TYPE dodas_output_bytes_per_frame gauge\n";
+    text << "dodas_output_bytes_per_frame " << (count ? windowOutput / count : 0) << '\n';
+    text << "# HELP dodas_output_bytes_total Bytes printed during the frames\n# TYPE dodas_output_bytes_total counter\n";
+    text << "dodas_output_bytes_total " << outputBytes << '\n';
+    text << "# HELP dodas_events_total Game events of each kind\n# TYPE dodas_events_total counter\n";
+    for (unsigned kind=0; kind<GAME_EVENT_KINDS; kind++)
+        text << "dodas_events_total{kind=\"" << gameEventNames[kind] << "\"} " << events[kind] << '\n';
+    text << "# HELP dodas_metrics_dropped_total Frame samples lost because the metrics thread was late\n";
+    text << "# TYPE dodas_metrics_dropped_total counter\n";
+    text << "dodas_metrics_dropped_total " << dropped.load(std::memory_order_relaxed) << '\n';
+    return text.str();
+}
+
+#ifdef _WIN32
+bool MetricsServer::start(const std::string&) {
+    return false; // No Unix domain sockets
+}
+void MetricsServer::stop() {}
+void MetricsServer::run() {}
+void MetricsServer::answer(int) {}
+#else
+#ifdef MSG_NOSIGNAL
+    #define METRICS_SEND_FLAGS MSG_NOSIGNAL // A scraper hanging up must not kill the game with SIGPIPE
+#else
+    #define METRICS_SEND_FLAGS 0 // SO_NOSIGPIPE is set on the socket instead
+#endif
+
+bool MetricsServer::start(const std::string& path) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+        return false;
+    std::strcpy(address.sun_path, path.c_str());
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+        return false;
+    unlink(path.c_str()); // Left behind by an instance that crashed
+    if (bind(listener, (sockaddr*)&address, sizeof(address)) < 0 || listen(listener, 4) < 0) {
+        close(listener);
+        listener = -1;
+        return false;
+    }
+    this->path = path;
+    window.resize(METRICS_WINDOW);
+    running = true;
+    thread = std::thread(&MetricsServer::run, this);
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (!running)
+        return;
+    running = false;
+    thread.join();
+    close(listener);
+    listener = -1;
+    unlink(path.c_str());
+}
+
+void MetricsServer::run() {
+    while (running) {
+        drain();
+        pollfd descriptor = {listener, POLLIN, 0};
+        if (poll(&descriptor, 1, METRICS_POLL) <= 0)
+            continue;
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0)
+            continue;
+        #ifdef SO_NOSIGPIPE
+            int on = 1;
+            setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+        #endif
+        drain();
+        answer(client);
+        close(client);
+    }
+}
+
+void MetricsServer::answer(int client) {
+    // Clients that speak first are expected to be HTTP, the others (socat, nc) get the text right away
+    char request[1024];
+    bool http = false;
+    pollfd descriptor = {client, POLLIN, 0};
+    if (poll(&descriptor, 1, METRICS_POLL) > 0) {
+        ssize_t size = recv(client, request, sizeof(request), 0);
+        http = size >= 4 && std::memcmp(request, "GET ", 4) == 0;
+    }
+    std::string body = format();
+    std::string response;
+    if (http) {
+        response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: ";
+        response += std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n";
+    }
+    response += body;
+    std::size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t size = send(client, response.data() + sent, response.size() - sent, METRICS_SEND_FLAGS);
+        if (size <= 0)
+            return;
+        sent += size;
+    }
+}
+#endif
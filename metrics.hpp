@@ -0,0 +1,89 @@
+#pragma once
+#include "dodas.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define METRICS_SOCKET "/tmp/dodas-%d.sock" // Default path of the metrics socket, %d is the pid so that instances don't collide
+#define METRICS_RING 1024 // Frame samples buffered between the frame loop and the metrics thread
+#define METRICS_WINDOW 1000 // Frames the quantiles and the per-frame averages are computed on
+#define METRICS_POLL 100 // Milliseconds the metrics thread waits for a scraper before draining the samples again
+
+// What the frame loop knows about a frame, handed to the metrics thread as it is
+struct FrameSample {
+    unsigned frame = 0;
+    std::chrono::steady_clock::time_point end; // When the frame was over, for the achieved TPS
+    std::chrono::nanoseconds duration{0}; // Simulation and rendering, without the sleep between frames
+    uint32_t allocations = 0; // Heap allocations of the process during the frame
+    uint32_t outputBytes = 0; // Bytes written to std::cout during the frame
+    uint16_t entities[Type::QUEEN + 1] = {}; // Alive entities of each Type at the end of the frame
+    uint16_t events[GAME_EVENT_KINDS] = {}; // GameEvents of each kind consumed at the end of the frame
+};
+
+std::string defaultMetricsPath(); // METRICS_SOCKET with the pid of the process
+
+// Fills the entity counts of the sample from the lists of the world
+void countEntities(const GameWorld&, FrameSample&);
+
+// Stream buffer forwarding everything to another one, counting the bytes, to measure what the game prints
+class CountingBuffer : public std::streambuf {
+public:
+    std::streambuf* const destination;
+    std::atomic<unsigned long long> bytes{0};
+
+    CountingBuffer(std::streambuf* destination) : destination(destination) {}
+
+protected:
+    std::streamsize xsputn(const char* data, std::streamsize count) override {
+        bytes.fetch_add(count, std::memory_order_relaxed);
+        return destination->sputn(data, count);
+    }
+    int_type overflow(int_type c) override {
+        if (traits_type::eq_int_type(c, traits_type::eof()))
+            return traits_type::not_eof(c);
+        bytes.fetch_add(1, std::memory_order_relaxed);
+        return destination->sputc(traits_type::to_char_type(c));
+    }
+    int sync() override { return destination->pubsync(); }
+};
+
+// Serves the metrics of the running game in the Prometheus text format on a Unix domain socket (POSIX only).
+// The frame loop only copies a FrameSample into a lock-free ring; the metrics thread drains it, keeps the window
+// and formats the answer, so scraping costs nothing to the simulation. Plain HTTP GET requests get an HTTP answer
+// (curl --unix-socket), any other client gets the bare text.
+class MetricsServer {
+public:
+    ~MetricsServer();
+
+    bool start(const std::string& path); // Binds the socket and starts the thread, returns false if the socket can't be created
+    void stop(); // Joins the thread and removes the socket
+    void publish(const FrameSample&); // Called by the frame loop once per frame, never blocks
+
+private:
+    // Single producer (the frame loop), single consumer (the metrics thread)
+    FrameSample ring[METRICS_RING];
+    std::atomic<unsigned long long> head{0}; // Next sample to write
+    std::atomic<unsigned long long> tail{0}; // Next sample to read
+    std::atomic<unsigned long long> dropped{0}; // Samples lost because the ring was full
+
+    // Owned by the metrics thread
+    std::vector<FrameSample> window; // The last METRICS_WINDOW samples, window[frames % METRICS_WINDOW]
+    unsigned long long frames = 0;
+    unsigned long long allocations = 0;
+    unsigned long long outputBytes = 0;
+    unsigned long long events[GAME_EVENT_KINDS] = {};
+
+    std::string path;
+    int listener = -1;
+    std::atomic<bool> running{false};
+    std::thread thread;
+
+    void run();
+    void drain();
+    std::string format();
+    void answer(int client);
+};
@@ -0,0 +1,117 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+
+#define POOL_BLOCK 256 // Slots requested from the heap at once when a pool is empty
+
+// Blocks requested by all the pools since the start, a pool that stopped growing doesn't touch the heap anymore
+extern std::atomic<unsigned long long> poolBlocks;
+// Heap allocations of the whole process, defined by allocations.cpp in the binaries that count them
+extern std::atomic<unsigned long long> heapAllocations;
+
+// Free list of slots fitting a T, one list per thread. Slots are never given back to the heap, and an object can be
+// freed by a different thread than the one that allocated it (the input thread spawns the bullets of the player,
+// the frame thread frees them): the slot joins the free list of the thread that freed it. So that those slots don't
+// pile up there while the other thread keeps growing its own, a list longer than 2*POOL_BLOCK hands POOL_BLOCK slots
+// to a shared list, which a thread drains before growing when its own list runs dry.
+template <typename T>
+class Pool {
+public:
+    static void* allocate() {
+        FreeList& list = freeList();
+        if (list.head == nullptr)
+            reclaim(list);
+        if (list.head == nullptr)
+            grow(list);
+        Slot* slot = list.head;
+        list.head = slot->next;
+        list.size--;
+        return slot;
+    }
+    static void deallocate(void* pointer) {
+        FreeList& list = freeList();
+        Slot* slot = (Slot*)pointer;
+        slot->next = list.head;
+        list.head = slot;
+        if (++list.size >= 2 * POOL_BLOCK)
+            handOver(list);
+    }
+
+private:
+    union Slot {
+        Slot* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+    struct FreeList {
+        Slot* head = nullptr;
+        std::size_t size = 0;
+    };
+
+    static FreeList& freeList() {
+        thread_local FreeList list;
+        return list;
+    }
+    static FreeList& shared() { // Guarded by sharedMutex
+        static FreeList list;
+        return list;
+    }
+    static std::mutex& sharedMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+    static void grow(FreeList& list) {
+        Slot* block = (Slot*)::operator new(sizeof(Slot) * POOL_BLOCK);
+        for (std::size_t j=0; j<POOL_BLOCK; j++)
+            block[j].next = j + 1 < POOL_BLOCK ? &block[j + 1] : list.head;
+        list.head = block;
+        list.size += POOL_BLOCK;
+        poolBlocks++;
+    }
+    static void handOver(FreeList& list) { // Moves the first POOL_BLOCK slots of list to the shared list
+        Slot* first = list.head;
+        Slot* last = first;
+        for (std::size_t j=1; j<POOL_BLOCK; j++)
+            last = last->next;
+        list.head = last->next;
+        list.size -= POOL_BLOCK;
+        std::lock_guard<std::mutex> lock(sharedMutex());
+        last->next = shared().head;
+        shared().head = first;
+        shared().size += POOL_BLOCK;
+    }
+    static void reclaim(FreeList& list) { // Takes the whole shared list, list must be empty
+        std::lock_guard<std::mutex> lock(sharedMutex());
+        list = shared();
+        shared() = FreeList();
+    }
+};
+
+// Allocator for std::allocate_shared and node-based containers: single objects come from Pool, arrays from the heap
+template <typename T>
+class PoolAllocator {
+public:
+    typedef T value_type;
+
+    PoolAllocator() = default;
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) {}
+
+    T* allocate(std::size_t count) {
+        if (count != 1)
+            return (T*)::operator new(count * sizeof(T));
+        return (T*)Pool<T>::allocate();
+    }
+    void deallocate(T* pointer, std::size_t count) {
+        if (count != 1)
+            ::operator delete(pointer);
+        else
+            Pool<T>::deallocate(pointer);
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>&) const { return false; }
+};
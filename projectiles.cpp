@@ -0,0 +1,156 @@
+// Projectile benchmark: the cost of advancing the projectiles in bullet-heavy frames, with each kernel of this build
+//
+//  ./projectiles [-p policy] [-f frames] [-m frames] [-r repeats] [-s seed] [-c scenario] [-N]
+//
+// The bot plays -f frames in hardcore mode (-N for normal mode), then -m more frames. Before each of those, the
+// projectiles are packed in a batch and every kernel (advance.hpp) advances it -r times, then a fork of the world runs
+// GameWorld::moveProjectiles, which doesn't use the kernels. The kernels must give the same cells as the scalar one.
+// kernel_ns is the time of a kernel per projectile, pack_ns the time of packing them, move_us the time of
+// moveProjectiles per frame: a kernel can only pay off in the game if kernel_ns + pack_ns is well below the scalar one.
+#include "advance.hpp"
+#include "bot.hpp"
+#include "scenario.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define PROJECTILES_WARMUP 300 // Default number of frames played before measuring
+#define PROJECTILES_FRAMES 1000 // Default number of frames measured
+#define PROJECTILES_REPEATS 1000 // Default number of runs of each kernel on the batch of a frame
+
+static_assert(HEIGHT * WIDTH <= INT16_MAX, "ProjectileBatch::cell holds the index of a cell of the field in an int16_t");
+
+static void pack(const GameWorld& world, ProjectileBatch& batch) {
+    batch.resize(world.bullets.size() + world.enemyBullets.size());
+    std::size_t j = 0;
+    auto add = [&](Entity* projectile, Direction direction) {
+        sista::Coordinates offset = directionOffset(direction);
+        batch.y[j] = projectile->getCoordinates().y;
+        batch.x[j] = projectile->getCoordinates().x;
+        batch.dy[j] = (int16_t)offset.y;
+        batch.dx[j] = (int16_t)offset.x;
+        j++;
+    };
+    for (auto& bullet : world.bullets)
+        if (!bullet->collided)
+            add(bullet.get(), bullet->direction);
+    for (auto& enemyBullet : world.enemyBullets)
+        if (!enemyBullet->collided)
+            add(enemyBullet.get(), enemyBullet->direction);
+    batch.resize(j);
+}
+
+static bool sameOutputs(const ProjectileBatch& a, const ProjectileBatch& b) {
+    for (std::size_t j=0; j<a.size; j++)
+        if (a.toY[j] != b.toY[j] || a.toX[j] != b.toX[j] || a.cell[j] != b.cell[j])
+            return false;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::string policyName = "heuristic";
+    unsigned warmup = PROJECTILES_WARMUP;
+    unsigned frames = PROJECTILES_FRAMES;
+    unsigned repeats = PROJECTILES_REPEATS;
+    unsigned seed = 1;
+    bool hardcore = true;
+    std::string scenarioPath;
+    for (int i=1; i<argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-p" && i + 1 < argc) {
+            policyName = argv[++i];
+        } else if (arg == "-f" && i + 1 < argc) {
+            warmup = std::atoi(argv[++i]);
+        } else if (arg == "-m" && i + 1 < argc) {
+            frames = std::atoi(argv[++i]);
+        } else if (arg == "-r" && i + 1 < argc) {
+            repeats = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "-s" && i + 1 < argc) {
+            seed = std::atoi(argv[++i]);
+        } else if (arg == "-c" && i + 1 < argc) {
+            scenarioPath = argv[++i];
+        } else if (arg == "-N") {
+            hardcore = false;
+        } else {
+            std::cerr << "Unknown argument " << arg << std::endl;
+            return 1;
+        }
+    }
+    std::unique_ptr<Policy> policy = makePolicy(policyName, seed);
+    if (policy == nullptr) {
+        std::cerr << "Unknown policy " << policyName << std::endl;
+        return 1;
+    }
+
+    NullBuffer nullBuffer;
+    std::ostream report(std::cout.rdbuf());
+    std::cout.rdbuf(&nullBuffer); // Sista prints every change of the field on std::cout
+    GameWorld world(seed);
+    std::string error;
+    if (!scenarioPath.empty() && !loadScenario(world.scenario, scenarioPath, error)) {
+        std::cerr << "Invalid scenario, " << error << std::endl;
+        return 1;
+    }
+    world.populate();
+    unsigned i = 0; // Frame of the current game
+    auto play = [&]() {
+        applyAction(world, policy->decide(world));
+        world.update(i++, hardcore);
+        if (world.end) {
+            world.clear();
+            world.rng.seed(++seed);
+            world.populate();
+            i = 0;
+        }
+    };
+    for (unsigned frame=0; frame<warmup; frame++)
+        play();
+
+    ProjectileBatch batch, reference;
+    GameWorld fork(seed);
+    std::vector<std::chrono::nanoseconds> kernelTime(advanceKernelCount);
+    std::chrono::nanoseconds packTime{0}, moveTime{0};
+    unsigned long long projectiles = 0;
+    for (unsigned frame=0; frame<frames; frame++) {
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned r=0; r<repeats; r++)
+            pack(world, batch);
+        packTime += std::chrono::steady_clock::now() - start;
+        projectiles += batch.size;
+        for (unsigned k=0; k<advanceKernelCount; k++) {
+            start = std::chrono::steady_clock::now();
+            for (unsigned r=0; r<repeats; r++)
+                advanceKernels[k](batch, HEIGHT, WIDTH);
+            kernelTime[k] += std::chrono::steady_clock::now() - start;
+            if (k == 0) {
+                reference = batch;
+            } else if (!sameOutputs(batch, reference)) {
+                std::cerr << "The " << advanceKernelNames[k] << " kernel differs from the scalar one at frame " << i << std::endl;
+                return 1;
+            }
+        }
+
+        world.fork(fork);
+        fork.moveProjectiles(); // Untimed, so that the measured run doesn't pay for the cold caches
+        world.fork(fork);
+        start = std::chrono::steady_clock::now();
+        fork.moveProjectiles();
+        moveTime += std::chrono::steady_clock::now() - start;
+        play();
+    }
+
+    double perProjectile = (double)std::max(1ULL, projectiles * repeats);
+    report << "kernel\tprojectiles\tkernel_ns\tspeedup\tpack_ns\tmove_us" << std::endl;
+    report << std::fixed;
+    for (unsigned k=0; k<advanceKernelCount; k++) {
+        report << advanceKernelNames[k] << '\t' << std::setprecision(1) << (double)projectiles / std::max(1u, frames) << '\t';
+        report << std::setprecision(2) << kernelTime[k].count() / perProjectile << '\t';
+        report << (double)kernelTime[0].count() / std::max(1LL, (long long)kernelTime[k].count()) << '\t';
+        report << packTime.count() / perProjectile << '\t' << moveTime.count() / 1e3 / std::max(1u, frames) << std::endl;
+    }
+    return 0;
+}
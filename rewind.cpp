@@ -0,0 +1,194 @@
+#include "rewind.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+uint8_t encodeCell(Entity* entity) {
+    if (entity == nullptr)
+        return 0;
+    uint8_t variant = 0;
+    switch (entity->type) {
+    case Type::BULLET:
+        variant = ((Bullet*)entity)->direction;
+        break;
+    case Type::ENEMYBULLET:
+        variant = ((EnemyBullet*)entity)->direction;
+        break;
+    case Type::WALL:
+        variant = ((Wall*)entity)->strength == 0;
+        break;
+    case Type::MINE:
+        variant = ((Mine*)entity)->triggered();
+        break;
+    default:
+        break;
+    }
+    return (entity->type + 1) | (variant << 4);
+}
+
+RewindBuffer::RewindBuffer() : segments(REWIND_SEGMENTS), previous(WIDTH * HEIGHT), current(WIDTH * HEIGHT) {}
+
+void RewindBuffer::put(Segment& segment, const void* value, std::size_t size) {
+    segment.data.insert(segment.data.end(), (const uint8_t*)value, (const uint8_t*)value + size);
+}
+
+void RewindBuffer::record(GameWorld& world, unsigned frame) {
+    auto start = std::chrono::steady_clock::now();
+    auto encodeRows = [&](std::size_t begin, std::size_t end) { // Each band of rows writes its own part of current
+        for (unsigned short y=begin; y<end; y++)
+            for (unsigned short x=0; x<WIDTH; x++)
+                current[y*WIDTH + x] = encodeCell((Entity*)world.field->getPawn(y, x));
+    };
+    JobGraph graph;
+    graph.add(HEIGHT, REWIND_BAND_ROWS, encodeRows);
+    runJobs(world.jobs, graph);
+
+    bool keyframe = used == 0 || segments[(oldest + used - 1) % REWIND_SEGMENTS].offsets.size() == REWIND_KEYFRAME_PERIOD;
+    if (keyframe) {
+        if (used == REWIND_SEGMENTS) { // Evict the oldest keyframe period, its vectors keep their capacity
+            oldest = (oldest + 1) % REWIND_SEGMENTS;
+            used--;
+        }
+        Segment& segment = segments[(oldest + used) % REWIND_SEGMENTS];
+        used++;
+        segment.data.clear();
+        segment.offsets.clear();
+    }
+    Segment& segment = segments[(oldest + used - 1) % REWIND_SEGMENTS];
+    segment.offsets.push_back(segment.data.size());
+    uint32_t frame_ = frame;
+    int32_t hud[2] = {world.player->ammonitions, world.queen->life};
+    put(segment, &frame_, sizeof(frame_));
+    put(segment, hud, sizeof(hud));
+    if (keyframe) {
+        put(segment, current.data(), current.size());
+    } else {
+        std::size_t countOffset = segment.data.size();
+        uint16_t count = 0;
+        put(segment, &count, sizeof(count));
+        for (std::size_t j=0; j<current.size(); j++) {
+            if (current[j] == previous[j]) continue;
+            uint16_t cell = j;
+            put(segment, &cell, sizeof(cell));
+            put(segment, &current[j], 1);
+            count++;
+        }
+        std::memcpy(segment.data.data() + countOffset, &count, sizeof(count));
+    }
+    previous.swap(current);
+
+    std::chrono::nanoseconds cost = std::chrono::steady_clock::now() - start;
+    totalCost += cost;
+    maxCost = std::max(maxCost, cost);
+    recorded++;
+}
+
+std::size_t RewindBuffer::size() const {
+    if (used == 0)
+        return 0;
+    return (used - 1) * REWIND_KEYFRAME_PERIOD + segments[(oldest + used - 1) % REWIND_SEGMENTS].offsets.size();
+}
+
+bool RewindBuffer::reconstruct(std::size_t index, RewindFrame& frame) const {
+    if (index >= size())
+        return false;
+    const Segment& segment = segments[(oldest + index / REWIND_KEYFRAME_PERIOD) % REWIND_SEGMENTS];
+    const uint8_t* data = segment.data.data();
+    for (std::size_t j=0; j<=index % REWIND_KEYFRAME_PERIOD; j++) {
+        const uint8_t* record = data + segment.offsets[j];
+        uint32_t frame_;
+        int32_t hud[2];
+        std::memcpy(&frame_, record, sizeof(frame_));
+        std::memcpy(hud, record + sizeof(frame_), sizeof(hud));
+        record += sizeof(frame_) + sizeof(hud);
+        frame.frame = frame_;
+        frame.ammonitions = hud[0];
+        frame.life = hud[1];
+        if (j == 0) {
+            frame.cells.assign(record, record + WIDTH * HEIGHT);
+            continue;
+        }
+        uint16_t count;
+        std::memcpy(&count, record, sizeof(count));
+        record += sizeof(count);
+        for (uint16_t k=0; k<count; k++, record += 3) {
+            uint16_t cell;
+            std::memcpy(&cell, record, sizeof(cell));
+            frame.cells[cell] = record[2];
+        }
+    }
+    return true;
+}
+
+std::size_t RewindBuffer::bytes() const {
+    std::size_t total = (previous.capacity() + current.capacity()) * sizeof(uint8_t);
+    for (const Segment& segment : segments)
+        total += segment.data.capacity() + segment.offsets.capacity() * sizeof(uint32_t);
+    return total;
+}
+
+static StyleId styleOf(Type type, uint8_t variant, int life) {
+    if (type == Type::QUEEN)
+        return (StyleId)(QUEEN_STYLE + std::max(0, std::min(9, life)));
+    return (StyleId)(typeTraits[type].style + variant); // The variants are the consecutive styles after the first one
+}
+
+static void printCell(uint8_t code, int life) {
+    if (code == 0) {
+        std::cout << ' ';
+        return;
+    }
+    Style& style = styles[styleOf((Type)((code & 0x0F) - 1), code >> 4, life)];
+    style.settings.apply();
+    std::cout << style.symbol;
+    sista::resetAnsi();
+}
+
+void rewindViewer(const RewindBuffer& buffer, char (*getKey)()) {
+    if (buffer.size() == 0)
+        return;
+    std::size_t position = buffer.size() - 1;
+    RewindFrame frame;
+    char input = '_';
+    while (input != 'Q') {
+        buffer.reconstruct(position, frame);
+        sista::clearScreen();
+        std::cout << std::string(WIDTH + 2, '#') << '\n';
+        for (unsigned short y=0; y<HEIGHT; y++) {
+            std::cout << '#';
+            for (unsigned short x=0; x<WIDTH; x++)
+                printCell(frame.cells[y*WIDTH + x], frame.life);
+            std::cout << "#\n";
+        }
+        std::cout << std::string(WIDTH + 2, '#') << '\n';
+        std::cout << "Frame: " << frame.frame << "\tAmmonitions: " << frame.ammonitions << "\tLife: " << frame.life << '\n';
+        std::cout << "Rewind " << position + 1 << "/" << buffer.size();
+        std::cout << "\t" << buffer.bytes() / 1024 << "KiB, ";
+        std::cout << buffer.totalCost.count() / std::max(buffer.recorded, 1ULL) << "ns/frame ";
+        std::cout << "(max " << std::chrono::duration_cast<std::chrono::microseconds>(buffer.maxCost).count() << "us)\n";
+        std::cout << "'a'/'d' step, 'A'/'D' 10 frames, 'w'/'s' first/last, 'Q' to quit" << std::flush;
+        input = getKey();
+        switch (input) {
+        case 'a': case 'j':
+            if (position > 0) position--;
+            break;
+        case 'd': case 'l':
+            if (position + 1 < buffer.size()) position++;
+            break;
+        case 'A': case 'J':
+            position = position > 10 ? position - 10 : 0;
+            break;
+        case 'D': case 'L':
+            position = std::min(position + 10, buffer.size() - 1);
+            break;
+        case 'w': case 'W':
+            position = 0;
+            break;
+        case 's': case 'S':
+            position = buffer.size() - 1;
+            break;
+        default:
+            break;
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "dodas.hpp"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#define REWIND_KEYFRAME_PERIOD 50 // A full board is stored every REWIND_KEYFRAME_PERIOD recorded frames, the others only store what changed
+#define REWIND_SEGMENTS 60 // Number of keyframe periods kept, 60*50 frames are the last 5 minutes at 10 frames per second
+#define REWIND_BAND_ROWS 32 // Rows of the board a job of record() encodes, a smaller board is encoded by the frame loop alone
+
+// A delta stores the number of changed cells and the index of each of them in 16 bits
+static_assert(HEIGHT * WIDTH <= UINT16_MAX, "The deltas of RewindBuffer hold the index of a cell of the field in a uint16_t");
+
+// A cell is encoded in a byte: the low nibble is Type+1 (0 means empty), the high nibble is a per-type variant
+// (the direction of a bullet, whether a wall is destroyed or a mine is triggered)
+uint8_t encodeCell(Entity*);
+
+struct RewindFrame {
+    unsigned frame = 0;
+    int ammonitions = 0;
+    int life = 0;
+    std::vector<uint8_t> cells; // cells[y*WIDTH + x]
+};
+
+// Bounded ring buffer of the last REWIND_SEGMENTS*REWIND_KEYFRAME_PERIOD frames, fed by the frame loop
+class RewindBuffer {
+public:
+    RewindBuffer();
+
+    void record(GameWorld&, unsigned frame); // Scans the field and appends the frame, evicting the oldest keyframe period when full
+    std::size_t size() const; // Number of frames that can be reconstructed
+    bool reconstruct(std::size_t, RewindFrame&) const; // 0 is the oldest recorded frame, size()-1 the newest
+    std::size_t bytes() const; // Memory currently reserved by the recording
+
+    // Cost of record(), measured on every call
+    std::chrono::nanoseconds totalCost{0};
+    std::chrono::nanoseconds maxCost{0};
+    unsigned long long recorded = 0;
+
+private:
+    struct Segment {
+        std::vector<uint8_t> data; // One keyframe followed by up to REWIND_KEYFRAME_PERIOD-1 deltas
+        std::vector<uint32_t> offsets; // Where each frame starts in data
+    };
+    std::vector<Segment> segments;
+    unsigned oldest = 0; // Index of the oldest segment in the ring
+    unsigned used = 0; // Number of segments in use
+    std::vector<uint8_t> previous; // Board of the last recorded frame
+    std::vector<uint8_t> current;
+
+    void put(Segment&, const void*, std::size_t);
+};
+
+// Lets the player scrub through the recording, returns when 'Q' is pressed
+void rewindViewer(const RewindBuffer&, char (*)());
@@ -0,0 +1,242 @@
+#include "scenario.hpp"
+#include <bitset>
+#include <climits>
+#include <stdexcept>
+#ifdef _WIN32
+    #include <fstream>
+    #include <iterator>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+// The bytes of a file, mapped read-only on POSIX (the pages are only read once, by the parser), copied on Windows
+class MappedFile {
+public:
+    const char* data = nullptr;
+    std::size_t size = 0;
+
+    bool open(const std::string& path) {
+        #ifdef _WIN32
+            std::ifstream file(path, std::ios::binary);
+            if (!file)
+                return false;
+            copy.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            data = copy.data();
+            size = copy.size();
+            return true;
+        #else
+            int descriptor = ::open(path.c_str(), O_RDONLY);
+            if (descriptor < 0)
+                return false;
+            struct stat status;
+            if (fstat(descriptor, &status) < 0 || !S_ISREG(status.st_mode)) {
+                close(descriptor);
+                return false;
+            }
+            size = status.st_size;
+            if (size > 0 && size <= SCENARIO_MAX_SIZE) {
+                void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+                if (mapping != MAP_FAILED)
+                    data = (const char*)mapping;
+            }
+            close(descriptor); // The mapping stays valid
+            return data != nullptr || size == 0 || size > SCENARIO_MAX_SIZE;
+        #endif
+    }
+    ~MappedFile() {
+        #ifndef _WIN32
+            if (data != nullptr)
+                munmap((void*)data, size);
+        #endif
+    }
+
+private:
+    #ifdef _WIN32
+        std::string copy;
+    #endif
+};
+
+// first, first + step, ... up to last included, kept as read until ScenarioParser::range has checked them against the field
+struct ScenarioRange {
+    unsigned first, last, step;
+};
+
+// Reads the tokens of a scenario line by line, throwing std::runtime_error on the first mistake
+class ScenarioParser {
+public:
+    const char* cursor;
+    const char* end;
+    unsigned line = 1;
+
+    ScenarioParser(const char* data, std::size_t size) : cursor(data), end(data + size) {}
+
+    // Moves to the first token of the next line that has one, false at the end of the file
+    bool nextLine() {
+        while (cursor != end) {
+            skipBlanks();
+            if (cursor == end)
+                return false;
+            if (*cursor != '\n')
+                return true;
+            cursor++;
+            line++;
+        }
+        return false;
+    }
+    // The next token of the current line, empty if there is none left
+    std::string word() {
+        skipBlanks();
+        const char* start = cursor;
+        while (cursor != end && !isBlank(*cursor) && *cursor != '\n' && *cursor != '#')
+            cursor++;
+        return std::string(start, cursor);
+    }
+    bool atNumber() {
+        skipBlanks();
+        return cursor != end && *cursor >= '0' && *cursor <= '9';
+    }
+    unsigned number(const char* what) {
+        skipBlanks();
+        if (cursor == end || *cursor < '0' || *cursor > '9')
+            throw std::runtime_error(std::string("expected ") + what);
+        unsigned long value = 0;
+        while (cursor != end && *cursor >= '0' && *cursor <= '9') {
+            value = value * 10 + (*cursor++ - '0');
+            if (value > 1000000)
+                throw std::runtime_error(std::string(what) + " too large");
+        }
+        return value;
+    }
+    ScenarioRange range(const char* what, unsigned limit) {
+        ScenarioRange range;
+        range.first = range.last = number(what);
+        range.step = 1;
+        if (cursor != end && *cursor == '-') {
+            cursor++;
+            range.last = number(what);
+            if (cursor != end && *cursor == '/') {
+                cursor++;
+                range.step = number("step");
+            }
+        }
+        if (range.first > range.last || range.last >= limit || range.step == 0)
+            throw std::runtime_error(std::string("invalid ") + what);
+        return range;
+    }
+    void endOfLine() {
+        skipBlanks();
+        if (cursor != end && *cursor != '\n')
+            throw std::runtime_error("unexpected " + word());
+    }
+
+private:
+    static bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    void skipBlanks() {
+        while (cursor != end && isBlank(*cursor))
+            cursor++;
+        if (cursor != end && *cursor == '#') { // Comments run to the end of the line
+            while (cursor != end && *cursor != '\n')
+                cursor++;
+        }
+    }
+};
+
+static Type parseType(const std::string& name) {
+    for (unsigned type=0; type<=Type::QUEEN; type++)
+        if (name == typeNames[type])
+            return (Type)type;
+    throw std::runtime_error("unknown directive " + name);
+}
+
+bool loadScenario(Scenario& scenario, const std::string& path, std::string& error) {
+    MappedFile file;
+    if (!file.open(path)) {
+        error = "could not open " + path;
+        return false;
+    }
+    if (file.size > SCENARIO_MAX_SIZE) {
+        error = path + " is larger than " + std::to_string(SCENARIO_MAX_SIZE) + "B";
+        return false;
+    }
+
+    // Parsed into a local scenario first, so an invalid file leaves the current one untouched
+    Scenario parsed;
+    std::bitset<HEIGHT * WIDTH> taken;
+    bool sized = false;
+    unsigned players = 0, queens = 0;
+    ScenarioParser parser(file.data, file.size);
+    try {
+        while (parser.nextLine()) {
+            std::string directive = parser.word();
+            if (directive == "size") {
+                unsigned height = parser.number("height");
+                unsigned width = parser.number("width");
+                if (height != HEIGHT || width != WIDTH)
+                    throw std::runtime_error("the field is " + std::to_string(HEIGHT) + " " + std::to_string(WIDTH) + " in this build");
+                sized = true;
+            } else if (directive == "wave") {
+                Wave wave;
+                wave.type = parseType(parser.word());
+                if (wave.type != Type::ZOMBIE && wave.type != Type::WALKER)
+                    throw std::runtime_error("waves are of zombies or walkers");
+                wave.period = parser.number("period");
+                wave.phase = parser.number("phase");
+                if (wave.period == 0 || wave.phase >= wave.period)
+                    throw std::runtime_error("the phase must be lower than the period");
+                if (parser.atNumber()) {
+                    unsigned count = parser.number("count");
+                    if (count > HEIGHT * WIDTH)
+                        throw std::runtime_error("count too large");
+                    wave.count = count;
+                    if (parser.atNumber())
+                        wave.growth = parser.number("growth");
+                }
+                std::string option = parser.word();
+                if (!option.empty() && option != "hardcore")
+                    throw std::runtime_error("unexpected " + option);
+                wave.hardcore = !option.empty();
+                parsed.waves.push_back(wave);
+            } else {
+                Type type = parseType(directive);
+                if (typeTraits[type].collision == PROJECTILE)
+                    throw std::runtime_error("projectiles can't be placed");
+                ScenarioRange rows = parser.range("row", HEIGHT);
+                ScenarioRange columns = parser.range("column", WIDTH);
+                short strength = 0;
+                if (type == Type::WALL) {
+                    unsigned value = parser.number("strength");
+                    if (value == 0 || value > SHRT_MAX)
+                        throw std::runtime_error("invalid strength");
+                    strength = value;
+                }
+                if ((type == Type::PLAYER || type == Type::QUEEN) && (rows.first != rows.last || columns.first != columns.last))
+                    throw std::runtime_error(directive + " takes a single cell");
+                for (unsigned y=rows.first; y<=rows.last; y+=rows.step) {
+                    for (unsigned x=columns.first; x<=columns.last; x+=columns.step) {
+                        if (taken[y * WIDTH + x])
+                            throw std::runtime_error("{" + std::to_string(y) + ", " + std::to_string(x) + "} is already taken");
+                        taken[y * WIDTH + x] = true;
+                        parsed.placements.push_back({type, sista::Coordinates((unsigned short)y, (unsigned short)x), strength});
+                    }
+                }
+                players += type == Type::PLAYER;
+                queens += type == Type::QUEEN;
+            }
+            parser.endOfLine();
+        }
+        if (!sized)
+            throw std::runtime_error("missing size");
+        if (players != 1 || queens != 1)
+            throw std::runtime_error("there must be one player and one queen");
+    } catch (std::exception& exception) {
+        error = path + ":" + std::to_string(parser.line) + ": " + exception.what();
+        return false;
+    }
+
+    scenario = std::move(parsed);
+    return true;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "dodas.hpp"
+#include <string>
+
+// Scenario files are plain text, one directive per line, '#' starts a comment:
+//  size <height> <width>                        must match the field the game was compiled with, HEIGHT and WIDTH
+//  player <y> <x>                               exactly once
+//  queen <y> <x>                                exactly once
+//  <type> <rows> <columns> [strength]           worker, armed_worker, cannon, bomber, mine, wall, zombie or walker,
+//                                               strength is required for walls and refused for the others
+//  wave <type> <period> <phase> [count] [growth] [hardcore]
+//                                               zombie or walker, see Wave
+// Rows and columns are a number, a range "first-last" or a range with a step "first-last/step", so that a whole
+// block of entities takes one line. Two entities in the same cell are an error.
+#define SCENARIO_MAX_SIZE (1 << 20) // Bytes, larger files are refused
+
+// Replaces the scenario with the one in path, mapped in memory and parsed in a single pass. Returns false if the
+// file is missing or invalid, describing why in error, the scenario is then left untouched.
+bool loadScenario(Scenario&, const std::string& path, std::string& error);
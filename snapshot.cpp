@@ -0,0 +1,597 @@
+#include "snapshot.hpp"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+// Snapshot layout (native endianness, every list is prefixed by its uint32_t length):
+//  "DODS" | uint16 version | uint8 flags | uint32 frame | string rng
+//  balance {cannonFirePeriod, workerProductionPeriod, zombieMoving, zombieShooting, walkerMoving, startAmmonition,
+//           projectileSpeed, walkerPathfinding}
+//  scenario placements {type, y, x, strength} | scenario waves {type, period, phase, count, growth, hardcore}
+//  player {y, x, weapon, ammonitions, speed} | queen {y, x, life}
+//  bullets, enemyBullets, zombies, walkers, walls, mines, cannons, workerProbability, workers, armedWorkers, bombers
+//  with SNAPSHOT_FLAG_CELLS: cells {y, x, type, index in the list of the type, or SNAPSHOT_UNLISTED and the entity}
+// Coordinates are stored as two uint16_t, {y, x}.
+
+#define SNAPSHOT_FLAG_HARDCORE 1
+#define SNAPSHOT_FLAG_ENDLESS 2
+#define SNAPSHOT_FLAG_CELLS 4 // The field doesn't follow the coordinates of the listed entities, so every occupied cell is stored
+#define SNAPSHOT_UNLISTED UINT32_MAX // Index of a pawn left on the field by an entity that is in no list
+
+class SnapshotWriter {
+public:
+    std::string buffer;
+
+    template <typename T>
+    void put(T value) {
+        buffer.append((const char*)&value, sizeof(T));
+    }
+    void putString(const std::string& value) {
+        put<uint32_t>(value.size());
+        buffer.append(value);
+    }
+    void putCoordinates(sista::Coordinates coordinates) {
+        put<uint16_t>(coordinates.y);
+        put<uint16_t>(coordinates.x);
+    }
+};
+
+class SnapshotReader {
+public:
+    const std::string& buffer;
+    std::size_t offset = 0;
+
+    SnapshotReader(const std::string& buffer) : buffer(buffer) {}
+
+    template <typename T>
+    T get() {
+        if (offset + sizeof(T) > buffer.size())
+            throw std::runtime_error("truncated snapshot");
+        T value;
+        std::memcpy(&value, buffer.data() + offset, sizeof(T));
+        offset += sizeof(T);
+        return value;
+    }
+    std::string getString() {
+        uint32_t size = get<uint32_t>();
+        if (offset + size > buffer.size())
+            throw std::runtime_error("truncated snapshot");
+        std::string value = buffer.substr(offset, size);
+        offset += size;
+        return value;
+    }
+    sista::Coordinates getCoordinates() {
+        unsigned short y = get<uint16_t>();
+        unsigned short x = get<uint16_t>();
+        if (y >= HEIGHT || x >= WIDTH)
+            throw std::runtime_error("coordinates out of the field");
+        return sista::Coordinates(y, x);
+    }
+    Direction getDirection() {
+        uint8_t direction = get<uint8_t>();
+        if (direction > Direction::LEFT)
+            throw std::runtime_error("invalid direction");
+        return (Direction)direction;
+    }
+    unsigned short getSpeed() {
+        uint16_t speed = get<uint16_t>();
+        if (speed == 0 || speed > WIDTH)
+            throw std::runtime_error("invalid speed");
+        return speed;
+    }
+};
+
+// The state of each kind of entity, the same in the lists and for the pawns outside of them
+static void putEntity(SnapshotWriter& writer, Player& player) {
+    writer.putCoordinates(player.getCoordinates());
+    writer.put<uint8_t>(player.weapon);
+    writer.put<int32_t>(player.ammonitions);
+    writer.put<uint16_t>(player.speed);
+}
+static void putEntity(SnapshotWriter& writer, Queen& queen) {
+    writer.putCoordinates(queen.getCoordinates());
+    writer.put<int32_t>(queen.life);
+}
+static void putEntity(SnapshotWriter& writer, Bullet& bullet) {
+    writer.putCoordinates(bullet.getCoordinates());
+    writer.put<uint8_t>(bullet.direction);
+    writer.put<uint16_t>(bullet.speed);
+    writer.put<uint8_t>(bullet.collided);
+}
+static void putEntity(SnapshotWriter& writer, EnemyBullet& enemyBullet) {
+    writer.putCoordinates(enemyBullet.getCoordinates());
+    writer.put<uint8_t>(enemyBullet.direction);
+    writer.put<uint16_t>(enemyBullet.speed);
+    writer.put<uint8_t>(enemyBullet.collided);
+}
+static void putEntity(SnapshotWriter& writer, Walker& walker) {
+    writer.putCoordinates(walker.getCoordinates());
+    writer.put<uint8_t>(walker.exploded);
+}
+static void putEntity(SnapshotWriter& writer, Wall& wall) {
+    writer.putCoordinates(wall.getCoordinates());
+    writer.put<int16_t>(wall.strength);
+}
+static void putEntity(SnapshotWriter& writer, Mine& mine) {
+    writer.putCoordinates(mine.getCoordinates());
+    writer.put<uint8_t>(mine.triggered() | (mine.alive << 1));
+}
+static void putEntity(SnapshotWriter& writer, Bomber& bomber) {
+    writer.putCoordinates(bomber.getCoordinates());
+    writer.put<uint8_t>(bomber.exploded);
+}
+static void putEntity(SnapshotWriter& writer, Entity& entity) { // Zombies, cannons, workers and armed workers
+    writer.putCoordinates(entity.getCoordinates());
+}
+template <typename T>
+static void putList(SnapshotWriter& writer, const std::vector<std::shared_ptr<T>>& list) {
+    writer.put<uint32_t>(list.size());
+    for (auto& entity : list)
+        putEntity(writer, *entity);
+}
+static void putUnlisted(SnapshotWriter& writer, Entity* pawn) {
+    switch (pawn->type) {
+    case Type::PLAYER: putEntity(writer, *(Player*)pawn); break;
+    case Type::QUEEN: putEntity(writer, *(Queen*)pawn); break;
+    case Type::BULLET: putEntity(writer, *(Bullet*)pawn); break;
+    case Type::ENEMYBULLET: putEntity(writer, *(EnemyBullet*)pawn); break;
+    case Type::WALKER: putEntity(writer, *(Walker*)pawn); break;
+    case Type::WALL: putEntity(writer, *(Wall*)pawn); break;
+    case Type::MINE: putEntity(writer, *(Mine*)pawn); break;
+    case Type::BOMBER: putEntity(writer, *(Bomber*)pawn); break;
+    default: putEntity(writer, *pawn); break;
+    }
+}
+
+template <typename T>
+static void indexList(const std::vector<std::shared_ptr<T>>& list, std::unordered_map<const sista::Pawn*, uint32_t>& indexes) {
+    for (uint32_t j=0; j<list.size(); j++)
+        indexes[list[j].get()] = j;
+}
+// Whether every listed entity is the pawn in the cell of its coordinates and there is no other pawn, so that the field
+// can be rebuilt from the lists alone. It isn't after a horde was spawned over an entity that then moved (see GameWorld::fork).
+static bool fieldFollowsLists(GameWorld& world) {
+    std::size_t listed = 0;
+    bool regular = true;
+    auto check = [&](Entity* entity) {
+        sista::Coordinates coordinates = entity->getCoordinates();
+        regular = regular && !world.field->isOutOfBounds(coordinates) && world.field->getPawn(coordinates) == entity;
+        listed++;
+    };
+    check(world.player.get());
+    check(world.queen.get());
+    for (auto& bullet : world.bullets) check(bullet.get());
+    for (auto& enemyBullet : world.enemyBullets) check(enemyBullet.get());
+    for (auto& zombie : world.zombies) check(zombie.get());
+    for (auto& walker : world.walkers) check(walker.get());
+    for (auto& wall : world.walls) check(wall.get());
+    for (auto& mine : world.mines) check(mine.get());
+    for (auto& cannon : world.cannons) check(cannon.get());
+    for (auto& worker : world.workers) check(worker.get());
+    for (auto& worker : world.armedWorkers) check(worker.get());
+    for (auto& bomber : world.bombers) check(bomber.get());
+    if (!regular)
+        return false;
+    std::size_t occupied = 0; // An entity listed twice, or a pawn in no list, shows as a different count
+    for (unsigned short y=0; y<HEIGHT; y++)
+        for (unsigned short x=0; x<WIDTH; x++)
+            occupied += world.field->getPawn(y, x) != nullptr;
+    return occupied == listed;
+}
+
+bool saveSnapshot(GameWorld& world, const std::string& path, SnapshotInfo& info) {
+    auto start = std::chrono::steady_clock::now();
+    SnapshotWriter writer;
+    writer.buffer.reserve(4096);
+    writer.buffer.append(SNAPSHOT_MAGIC, 4);
+    writer.put<uint16_t>(SNAPSHOT_VERSION);
+    bool regular = fieldFollowsLists(world);
+    writer.put<uint8_t>((info.hardcore ? SNAPSHOT_FLAG_HARDCORE : 0) | (info.endless ? SNAPSHOT_FLAG_ENDLESS : 0) | (regular ? 0 : SNAPSHOT_FLAG_CELLS));
+    writer.put<uint32_t>(info.frame);
+    std::ostringstream rngState;
+    rngState << world.rng;
+    writer.putString(rngState.str());
+
+    const Balance& balance = world.balance;
+    writer.put<uint16_t>(balance.cannonFirePeriod);
+    writer.put<uint16_t>(balance.workerProductionPeriod);
+    writer.put<double>(balance.zombieMovingProbability);
+    writer.put<double>(balance.zombieShootingProbability);
+    writer.put<double>(balance.walkerMovingProbability);
+    writer.put<int32_t>(balance.startAmmonition);
+    writer.put<uint16_t>(balance.projectileSpeed);
+    writer.put<uint8_t>(balance.walkerPathfinding);
+    writer.put<uint32_t>(world.scenario.placements.size()); // For the games that follow in endless mode
+    for (const Placement& placement : world.scenario.placements) {
+        writer.put<uint8_t>(placement.type);
+        writer.putCoordinates(placement.coordinates);
+        writer.put<int16_t>(placement.strength);
+    }
+    writer.put<uint32_t>(world.scenario.waves.size());
+    for (const Wave& wave : world.scenario.waves) {
+        writer.put<uint8_t>(wave.type);
+        writer.put<uint32_t>(wave.period);
+        writer.put<uint32_t>(wave.phase);
+        writer.put<uint16_t>(wave.count);
+        writer.put<uint32_t>(wave.growth);
+        writer.put<uint8_t>(wave.hardcore);
+    }
+
+    putEntity(writer, *world.player);
+    putEntity(writer, *world.queen);
+    putList(writer, world.bullets);
+    putList(writer, world.enemyBullets);
+    putList(writer, world.zombies);
+    putList(writer, world.walkers);
+    putList(writer, world.walls);
+    putList(writer, world.mines);
+    putList(writer, world.cannons);
+    writer.put<double>(world.workerDistribution.p()); // Shared by all the workers and armed workers
+    putList(writer, world.workers);
+    putList(writer, world.armedWorkers);
+    putList(writer, world.bombers);
+
+    if (!regular) {
+        std::unordered_map<const sista::Pawn*, uint32_t> indexes;
+        indexes[world.player.get()] = 0;
+        indexes[world.queen.get()] = 0;
+        indexList(world.bullets, indexes);
+        indexList(world.enemyBullets, indexes);
+        indexList(world.zombies, indexes);
+        indexList(world.walkers, indexes);
+        indexList(world.walls, indexes);
+        indexList(world.mines, indexes);
+        indexList(world.cannons, indexes);
+        indexList(world.workers, indexes);
+        indexList(world.armedWorkers, indexes);
+        indexList(world.bombers, indexes);
+        std::size_t cells = 0;
+        std::size_t countOffset = writer.buffer.size();
+        writer.put<uint32_t>(0); // Filled in below
+        for (unsigned short y=0; y<HEIGHT; y++) {
+            for (unsigned short x=0; x<WIDTH; x++) {
+                Entity* pawn = (Entity*)world.field->getPawn(y, x);
+                if (pawn == nullptr)
+                    continue;
+                auto index = indexes.find(pawn);
+                writer.putCoordinates({y, x});
+                writer.put<uint8_t>(pawn->type);
+                writer.put<uint32_t>(index != indexes.end() ? index->second : SNAPSHOT_UNLISTED);
+                if (index == indexes.end())
+                    putUnlisted(writer, pawn);
+                cells++;
+            }
+        }
+        uint32_t count = cells;
+        std::memcpy(&writer.buffer[countOffset], &count, sizeof(count));
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+    file.write(writer.buffer.data(), writer.buffer.size());
+    if (!file)
+        return false;
+    info.bytes = writer.buffer.size();
+    info.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    trace(TRACE_INFO, SNAPSHOT_SAVED, TRACE_NO_TYPE, 0, 0, info.bytes);
+    return true;
+}
+
+template <typename T>
+static uint32_t readCount(SnapshotReader& reader, std::vector<std::shared_ptr<T>>& list) {
+    uint32_t count = reader.get<uint32_t>();
+    if (count > HEIGHT * WIDTH)
+        throw std::runtime_error("too many entities");
+    list.reserve(count);
+    return count;
+}
+
+template <typename T>
+static std::shared_ptr<T> getEntity(SnapshotReader& reader, GameWorld& world, const Balance&) { // Zombies, workers and armed workers
+    return makeEntity<T>(&world, reader.getCoordinates());
+}
+template <>
+std::shared_ptr<Player> getEntity<Player>(SnapshotReader& reader, GameWorld& world, const Balance&) {
+    std::shared_ptr<Player> player = makeEntity<Player>(&world, reader.getCoordinates());
+    uint8_t weapon = reader.get<uint8_t>();
+    if (weapon > Type::QUEEN)
+        throw std::runtime_error("invalid weapon");
+    player->weapon = (Type)weapon;
+    player->ammonitions = reader.get<int32_t>();
+    player->speed = reader.getSpeed();
+    return player;
+}
+template <>
+std::shared_ptr<Queen> getEntity<Queen>(SnapshotReader& reader, GameWorld& world, const Balance&) {
+    std::shared_ptr<Queen> queen = makeEntity<Queen>(&world, reader.getCoordinates());
+    queen->life = reader.get<int32_t>();
+    queen->showLife();
+    return queen;
+}
+template <>
+std::shared_ptr<Bullet> getEntity<Bullet>(SnapshotReader& reader, GameWorld& world, const Balance&) {
+    sista::Coordinates coordinates = reader.getCoordinates();
+    Direction direction = reader.getDirection();
+    std::shared_ptr<Bullet> bullet = makeEntity<Bullet>(&world, coordinates, direction, reader.getSpeed());
+    bullet->collided = reader.get<uint8_t>();
+    return bullet;
+}
+template <>
+std::shared_ptr<EnemyBullet> getEntity<EnemyBullet>(SnapshotReader& reader, GameWorld& world, const Balance&) {
+    sista::Coordinates coordinates = reader.getCoordinates();
+    Direction direction = reader.getDirection();
+    std::shared_ptr<EnemyBullet> enemyBullet = makeEntity<EnemyBullet>(&world, coordinates, direction, reader.getSpeed());
+    enemyBullet->collided = reader.get<uint8_t>();
+    return enemyBullet;
+}
+template <>
+std::shared_ptr<Walker> getEntity<Walker>(SnapshotReader& reader, GameWorld& world, const Balance&) {
+    std::shared_ptr<Walker> walker = makeEntity<Walker>(&world, reader.getCoordinates());
+    walker->exploded = reader.get<uint8_t>();
+    return walker;
+}
+template <>
+std::shared_ptr<Wall> getEntity<Wall>(SnapshotReader& reader, GameWorld& world, const Balance&) {
+    sista::Coordinates coordinates = reader.getCoordinates();
+    std::shared_ptr<Wall> wall = makeEntity<Wall>(&world, coordinates, reader.get<int16_t>());
+    if (wall->strength == 0)
+        wall->setStyle(DESTROYED_WALL_STYLE); // Destroyed walls are kept until the next frame, as in Bullet::move
+    return wall;
+}
+template <>
+std::shared_ptr<Mine> getEntity<Mine>(SnapshotReader& reader, GameWorld& world, const Balance&) {
+    std::shared_ptr<Mine> mine = makeEntity<Mine>(&world, reader.getCoordinates());
+    uint8_t state = reader.get<uint8_t>();
+    if (state & 1)
+        mine->setStyle(TRIGGERED_MINE_STYLE);
+    mine->alive = state & 2;
+    return mine;
+}
+template <>
+std::shared_ptr<Cannon> getEntity<Cannon>(SnapshotReader& reader, GameWorld& world, const Balance& balance) {
+    return makeEntity<Cannon>(&world, reader.getCoordinates(), balance.cannonFirePeriod);
+}
+template <>
+std::shared_ptr<Bomber> getEntity<Bomber>(SnapshotReader& reader, GameWorld& world, const Balance&) {
+    std::shared_ptr<Bomber> bomber = makeEntity<Bomber>(&world, reader.getCoordinates());
+    bomber->exploded = reader.get<uint8_t>();
+    return bomber;
+}
+template <typename T>
+static void getList(SnapshotReader& reader, GameWorld& world, const Balance& balance, std::vector<std::shared_ptr<T>>& list) {
+    uint32_t count = readCount(reader, list);
+    for (unsigned j=0; j<count; j++)
+        list.push_back(getEntity<T>(reader, world, balance));
+}
+static std::shared_ptr<Entity> getUnlisted(SnapshotReader& reader, GameWorld& world, const Balance& balance, Type type) {
+    switch (type) {
+    case Type::PLAYER: return getEntity<Player>(reader, world, balance);
+    case Type::WORKER: return getEntity<Worker>(reader, world, balance);
+    case Type::ARMED_WORKER: return getEntity<ArmedWorker>(reader, world, balance);
+    case Type::CANNON: return getEntity<Cannon>(reader, world, balance);
+    case Type::BOMBER: return getEntity<Bomber>(reader, world, balance);
+    case Type::BULLET: return getEntity<Bullet>(reader, world, balance);
+    case Type::MINE: return getEntity<Mine>(reader, world, balance);
+    case Type::WALL: return getEntity<Wall>(reader, world, balance);
+    case Type::ZOMBIE: return getEntity<Zombie>(reader, world, balance);
+    case Type::WALKER: return getEntity<Walker>(reader, world, balance);
+    case Type::ENEMYBULLET: return getEntity<EnemyBullet>(reader, world, balance);
+    case Type::QUEEN: return getEntity<Queen>(reader, world, balance);
+    }
+    throw std::runtime_error("invalid type");
+}
+template <typename T>
+static std::shared_ptr<Entity> listed(const std::vector<std::shared_ptr<T>>& list, uint32_t index) {
+    return index < list.size() ? list[index] : nullptr;
+}
+
+bool loadSnapshot(GameWorld& world, const std::string& path, SnapshotInfo& info) {
+    auto start = std::chrono::steady_clock::now();
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    std::string buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    // Everything is parsed into local lists first, so an invalid snapshot leaves the current game untouched
+    Balance balance;
+    Scenario scenario;
+    std::shared_ptr<Player> player;
+    std::shared_ptr<Queen> queen;
+    std::vector<std::shared_ptr<Bullet>> bullets;
+    std::vector<std::shared_ptr<EnemyBullet>> enemyBullets;
+    std::vector<std::shared_ptr<Zombie>> zombies;
+    std::vector<std::shared_ptr<Walker>> walkers;
+    std::vector<std::shared_ptr<Wall>> walls;
+    std::vector<std::shared_ptr<Mine>> mines;
+    std::vector<std::shared_ptr<Cannon>> cannons;
+    std::vector<std::shared_ptr<Worker>> workers;
+    std::vector<std::shared_ptr<ArmedWorker>> armedWorkers;
+    std::vector<std::shared_ptr<Bomber>> bombers;
+    std::vector<std::pair<sista::Coordinates, std::shared_ptr<Entity>>> cells; // With SNAPSHOT_FLAG_CELLS, the pawn of every occupied cell
+    std::mt19937 rngState;
+    double workerProbability;
+    uint8_t flags;
+    try {
+        SnapshotReader reader(buffer);
+        if (buffer.compare(0, 4, SNAPSHOT_MAGIC) != 0)
+            throw std::runtime_error("not a Dodas snapshot");
+        reader.offset = 4;
+        if (reader.get<uint16_t>() != SNAPSHOT_VERSION)
+            throw std::runtime_error("unsupported snapshot version");
+        flags = reader.get<uint8_t>();
+        info.hardcore = flags & SNAPSHOT_FLAG_HARDCORE;
+        info.endless = flags & SNAPSHOT_FLAG_ENDLESS;
+        info.frame = reader.get<uint32_t>();
+        std::istringstream rngStream(reader.getString());
+        rngStream >> rngState;
+        if (!rngStream)
+            throw std::runtime_error("invalid rng state");
+
+        balance.cannonFirePeriod = reader.get<uint16_t>();
+        balance.workerProductionPeriod = reader.get<uint16_t>();
+        balance.zombieMovingProbability = reader.get<double>();
+        balance.zombieShootingProbability = reader.get<double>();
+        balance.walkerMovingProbability = reader.get<double>();
+        balance.startAmmonition = reader.get<int32_t>();
+        balance.projectileSpeed = reader.getSpeed();
+        balance.walkerPathfinding = reader.get<uint8_t>();
+        auto probability = [](double p) { return p >= 0.0 && p <= 1.0; };
+        if (balance.cannonFirePeriod == 0 || balance.workerProductionPeriod == 0 || !probability(balance.zombieMovingProbability)
+            || !probability(balance.zombieShootingProbability) || !probability(balance.walkerMovingProbability))
+            throw std::runtime_error("invalid balance");
+        uint32_t count = reader.get<uint32_t>();
+        if (count > HEIGHT * WIDTH)
+            throw std::runtime_error("too many placements");
+        for (unsigned j=0; j<count; j++) {
+            Placement placement;
+            uint8_t type = reader.get<uint8_t>();
+            if (type > Type::QUEEN)
+                throw std::runtime_error("invalid type");
+            placement.type = (Type)type;
+            placement.coordinates = reader.getCoordinates();
+            placement.strength = reader.get<int16_t>();
+            scenario.placements.push_back(placement);
+        }
+        count = reader.get<uint32_t>();
+        if (count > HEIGHT * WIDTH)
+            throw std::runtime_error("too many waves");
+        for (unsigned j=0; j<count; j++) {
+            Wave wave;
+            uint8_t type = reader.get<uint8_t>();
+            if (type != Type::ZOMBIE && type != Type::WALKER)
+                throw std::runtime_error("invalid wave");
+            wave.type = (Type)type;
+            wave.period = reader.get<uint32_t>();
+            wave.phase = reader.get<uint32_t>();
+            wave.count = reader.get<uint16_t>();
+            wave.growth = reader.get<uint32_t>();
+            wave.hardcore = reader.get<uint8_t>();
+            if (wave.period == 0 || wave.phase >= wave.period || wave.count > HEIGHT * WIDTH)
+                throw std::runtime_error("invalid wave");
+            scenario.waves.push_back(wave);
+        }
+
+        player = getEntity<Player>(reader, world, balance);
+        queen = getEntity<Queen>(reader, world, balance);
+        getList(reader, world, balance, bullets);
+        getList(reader, world, balance, enemyBullets);
+        getList(reader, world, balance, zombies);
+        getList(reader, world, balance, walkers);
+        getList(reader, world, balance, walls);
+        getList(reader, world, balance, mines);
+        getList(reader, world, balance, cannons);
+        workerProbability = reader.get<double>();
+        if (!probability(workerProbability))
+            throw std::runtime_error("invalid worker probability");
+        getList(reader, world, balance, workers);
+        getList(reader, world, balance, armedWorkers);
+        getList(reader, world, balance, bombers);
+
+        if (flags & SNAPSHOT_FLAG_CELLS) {
+            count = reader.get<uint32_t>();
+            if (count > HEIGHT * WIDTH)
+                throw std::runtime_error("too many cells");
+            for (unsigned j=0; j<count; j++) {
+                sista::Coordinates cell = reader.getCoordinates();
+                uint8_t type = reader.get<uint8_t>();
+                uint32_t index = reader.get<uint32_t>();
+                if (type > Type::QUEEN)
+                    throw std::runtime_error("invalid type");
+                std::shared_ptr<Entity> pawn;
+                if (index == SNAPSHOT_UNLISTED) {
+                    pawn = getUnlisted(reader, world, balance, (Type)type);
+                } else {
+                    switch ((Type)type) {
+                    case Type::PLAYER: pawn = index == 0 ? player : nullptr; break;
+                    case Type::QUEEN: pawn = index == 0 ? queen : nullptr; break;
+                    case Type::BULLET: pawn = listed(bullets, index); break;
+                    case Type::ENEMYBULLET: pawn = listed(enemyBullets, index); break;
+                    case Type::ZOMBIE: pawn = listed(zombies, index); break;
+                    case Type::WALKER: pawn = listed(walkers, index); break;
+                    case Type::WALL: pawn = listed(walls, index); break;
+                    case Type::MINE: pawn = listed(mines, index); break;
+                    case Type::CANNON: pawn = listed(cannons, index); break;
+                    case Type::WORKER: pawn = listed(workers, index); break;
+                    case Type::ARMED_WORKER: pawn = listed(armedWorkers, index); break;
+                    case Type::BOMBER: pawn = listed(bombers, index); break;
+                    }
+                    if (pawn == nullptr)
+                        throw std::runtime_error("invalid index");
+                }
+                cells.emplace_back(cell, pawn);
+            }
+        }
+        if (reader.offset != buffer.size())
+            throw std::runtime_error("trailing bytes in snapshot");
+    } catch (std::exception&) {
+        trace(TRACE_ERROR, SNAPSHOT_INVALID, TRACE_NO_TYPE, 0, 0, buffer.size());
+        return false;
+    }
+
+    // Swap the new state in and rebuild the field in a single pass
+    world.balance = balance;
+    world.applyBalance();
+    world.scenario = std::move(scenario);
+    world.rng = rngState;
+    world.workerDistribution = std::bernoulli_distribution(workerProbability);
+    world.end = false;
+    world.player = player;
+    world.queen = queen;
+    world.bullets.swap(bullets);
+    world.enemyBullets.swap(enemyBullets);
+    world.zombies.swap(zombies);
+    world.walkers.swap(walkers);
+    world.walls.swap(walls);
+    world.mines.swap(mines);
+    world.cannons.swap(cannons);
+    world.workers.swap(workers);
+    world.armedWorkers.swap(armedWorkers);
+    world.bombers.swap(bombers);
+    world.lanes.clear();
+    for (auto& bullet : world.bullets)
+        world.lanes.insert(bullet.get());
+    for (auto& enemyBullet : world.enemyBullets)
+        world.lanes.insert(enemyBullet.get());
+
+    world.field->clear();
+    if (flags & SNAPSHOT_FLAG_CELLS) {
+        // Placed cell by cell as GameWorld::fork does, the pawns outside the lists are owned by the field alone
+        for (auto& cell : cells) {
+            sista::Coordinates coordinates = cell.second->getCoordinates();
+            cell.second->setCoordinates(cell.first);
+            world.field->addPawn(cell.second);
+            cell.second->setCoordinates(coordinates);
+        }
+    } else {
+        world.field->addPawn(world.player);
+        world.field->addPawn(world.queen);
+        for (auto& bullet : world.bullets)
+            world.field->addPawn(bullet);
+        for (auto& enemyBullet : world.enemyBullets)
+            world.field->addPawn(enemyBullet);
+        for (auto& zombie : world.zombies)
+            world.field->addPawn(zombie);
+        for (auto& walker : world.walkers)
+            world.field->addPawn(walker);
+        for (auto& wall : world.walls)
+            world.field->addPawn(wall);
+        for (auto& mine : world.mines)
+            world.field->addPawn(mine);
+        for (auto& cannon : world.cannons)
+            world.field->addPawn(cannon);
+        for (auto& worker : world.workers)
+            world.field->addPawn(worker);
+        for (auto& worker : world.armedWorkers)
+            world.field->addPawn(worker);
+        for (auto& bomber : world.bombers)
+            world.field->addPawn(bomber);
+    }
+
+    info.bytes = buffer.size();
+    info.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    trace(TRACE_INFO, SNAPSHOT_LOADED, TRACE_NO_TYPE, 0, 0, info.bytes);
+    return true;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "dodas.hpp"
+#include <chrono>
+#include <string>
+
+#define SNAPSHOT_MAGIC "DODS"
+#define SNAPSHOT_VERSION 4
+
+// Everything main() needs to resume a run, plus the cost of producing/consuming the snapshot
+struct SnapshotInfo {
+    unsigned frame = 0; // The frame counter of main() at the moment of the save
+    bool hardcore = false;
+    bool endless = false;
+    std::size_t bytes = 0; // Size of the snapshot on disk
+    std::chrono::microseconds elapsed{0}; // Time spent serializing (or deserializing and rebuilding the field)
+};
+
+// Writes the whole state of the world (entity lists, player, queen, pawns outside the lists, RNG, balance, scenario) to path,
+// returns false on I/O errors
+bool saveSnapshot(GameWorld&, const std::string& path, SnapshotInfo& info);
+// Replaces the whole state of the world with the one stored in path and rebuilds its field, returns false if the file is missing or invalid
+bool loadSnapshot(GameWorld&, const std::string& path, SnapshotInfo& info);
@@ -0,0 +1,285 @@
+// Soak runner: a bot plays game after game in the same world for hours, reporting frame times and memory at regular intervals
+//
+//  ./soak [-p policy] [-f frames] [-t seconds] [-i interval] [-s seed] [-c scenario] [-j threads] [-H] [-r] [-m] [-k]
+//
+// -c plays the layout and the waves of a scenario file (scenario.hpp) instead of the built-in ones.
+// -j runs the parallel phases of the frames on a JobSystem of that many threads (0 for one per core), 1 by default.
+// -H plays in hardcore mode, -r renders the field as the game does instead of running headless.
+// -m prints the memory taken by each entity type at the end, at the peak number of entities of that type.
+// -k gives the commands of the bot from a second thread, as the input thread of the game does with the keys, so that the
+// entities the player spawns are allocated on one thread and freed on the other: pool_blocks must still stop growing.
+// It stops after the given number of frames or seconds, whichever comes first (0 means no limit).
+#include "bot.hpp"
+#include "scenario.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <unistd.h>
+
+#define SOAK_FRAMES 1000000 // Default number of frames
+#define SOAK_INTERVAL 10000 // Frames between two reports
+
+static std::size_t residentKiB() {
+    std::ifstream statm("/proc/self/statm");
+    std::size_t size, resident;
+    if (statm >> size >> resident)
+        return resident * (sysconf(_SC_PAGESIZE) / 1024);
+    struct rusage usage; // Without procfs the peak is the best approximation
+    getrusage(RUSAGE_SELF, &usage);
+    #ifdef __APPLE__
+        return usage.ru_maxrss / 1024; // Bytes on macOS
+    #else
+        return usage.ru_maxrss;
+    #endif
+}
+
+// Allocator that records how many bytes std::allocate_shared asks for an entity and its control block,
+// which is the size of a slot in the pool of that type
+template <typename T>
+class SizeProbe {
+public:
+    typedef T value_type;
+
+    SizeProbe(std::size_t& bytes) : bytes(&bytes) {}
+    template <typename U>
+    SizeProbe(const SizeProbe<U>& other) : bytes(other.bytes) {}
+
+    T* allocate(std::size_t count) {
+        *bytes = count * sizeof(T);
+        return (T*)::operator new(*bytes);
+    }
+    void deallocate(T* pointer, std::size_t) {
+        ::operator delete(pointer);
+    }
+
+    template <typename U>
+    bool operator==(const SizeProbe<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const SizeProbe<U>&) const { return false; }
+
+    std::size_t* bytes;
+};
+
+struct MemoryRow {
+    Type type;
+    std::size_t object; // sizeof the entity
+    std::size_t slot; // Pool slot, with the control block of the shared_ptr
+    std::size_t peak = 0; // Most entities of the type alive at the end of a frame
+};
+
+template <typename T>
+static MemoryRow memoryRow(Type type) {
+    MemoryRow row;
+    row.type = type;
+    row.object = sizeof(T);
+    std::allocate_shared<T>(SizeProbe<T>(row.slot));
+    return row;
+}
+
+template <std::size_t N>
+static void printMemory(std::ostream& report, const MemoryRow (&rows)[N]) {
+    report << "type\tobject_B\tslot_B\tpeak\tpeak_KiB" << std::endl;
+    std::size_t total = 0;
+    for (const MemoryRow& row : rows) {
+        report << typeNames[row.type] << '\t' << row.object << '\t' << row.slot << '\t' << row.peak;
+        report << '\t' << std::setprecision(1) << row.slot * row.peak / 1024.0 << std::endl;
+        total += row.slot * row.peak;
+    }
+    report << "total\t\t\t\t" << total / 1024.0 << std::endl;
+}
+
+// Applies the actions of the bot on its own thread, one at a time, while the frame thread waits
+class InputThread {
+public:
+    InputThread(GameWorld& world) : world(world), thread([this]() { run(); }) {}
+    ~InputThread() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        changed.notify_all();
+        thread.join();
+    }
+
+    void apply(const BotAction& action) {
+        std::unique_lock<std::mutex> lock(mutex);
+        pending = action;
+        ready = true;
+        changed.notify_all();
+        changed.wait(lock, [this]() { return !ready; });
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            changed.wait(lock, [this]() { return ready || stopping; });
+            if (stopping)
+                return;
+            {
+                std::lock_guard<std::mutex> worldLock(world.mutex);
+                applyAction(world, pending);
+            }
+            ready = false;
+            changed.notify_all();
+        }
+    }
+
+    GameWorld& world;
+    std::mutex mutex;
+    std::condition_variable changed;
+    BotAction pending;
+    bool ready = false;
+    bool stopping = false;
+    std::thread thread; // Last, so that it starts once the rest is initialised
+};
+
+int main(int argc, char** argv) {
+    std::string policyName = "heuristic";
+    unsigned long long maxFrames = SOAK_FRAMES;
+    unsigned long long maxSeconds = 0;
+    unsigned interval = SOAK_INTERVAL;
+    unsigned seed = 1;
+    bool hardcore = false;
+    bool render = false;
+    bool memory = false;
+    bool inputThread = false;
+    unsigned threads = 1;
+    std::string scenarioPath;
+    for (int i=1; i<argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-p" && i + 1 < argc) {
+            policyName = argv[++i];
+        } else if (arg == "-f" && i + 1 < argc) {
+            maxFrames = std::atoll(argv[++i]);
+        } else if (arg == "-t" && i + 1 < argc) {
+            maxSeconds = std::atoll(argv[++i]);
+        } else if (arg == "-i" && i + 1 < argc) {
+            interval = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "-s" && i + 1 < argc) {
+            seed = std::atoi(argv[++i]);
+        } else if (arg == "-c" && i + 1 < argc) {
+            scenarioPath = argv[++i];
+        } else if (arg == "-j" && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (arg == "-H") {
+            hardcore = true;
+        } else if (arg == "-r") {
+            render = true;
+        } else if (arg == "-m") {
+            memory = true;
+        } else if (arg == "-k") {
+            inputThread = true;
+        } else {
+            std::cerr << "Unknown argument " << arg << std::endl;
+            return 1;
+        }
+    }
+    std::unique_ptr<Policy> policy = makePolicy(policyName, seed);
+    if (policy == nullptr) {
+        std::cerr << "Unknown policy " << policyName << std::endl;
+        return 1;
+    }
+
+    NullBuffer nullBuffer;
+    std::ostream report(std::cout.rdbuf());
+    if (!render)
+        std::cout.rdbuf(&nullBuffer); // Sista prints every change of the field on std::cout
+    sista::Border border('#', {sista::ForegroundColor::WHITE, sista::BackgroundColor::BLACK, sista::Attribute::BRIGHT});
+    sista::Cursor cursor;
+
+    MemoryRow memoryRows[] = { // In the order of the lists of GameWorld
+        memoryRow<Bullet>(Type::BULLET), memoryRow<EnemyBullet>(Type::ENEMYBULLET), memoryRow<Zombie>(Type::ZOMBIE),
+        memoryRow<Walker>(Type::WALKER), memoryRow<Wall>(Type::WALL), memoryRow<Mine>(Type::MINE), memoryRow<Cannon>(Type::CANNON),
+        memoryRow<ArmedWorker>(Type::ARMED_WORKER), memoryRow<Worker>(Type::WORKER), memoryRow<Bomber>(Type::BOMBER)
+    };
+    GameWorld world(seed);
+    JobSystem jobs(threads);
+    world.jobs = &jobs;
+    std::string error;
+    if (!scenarioPath.empty() && !loadScenario(world.scenario, scenarioPath, error)) {
+        std::cerr << "Invalid scenario, " << error << std::endl;
+        return 1;
+    }
+    world.populate();
+    std::unique_ptr<InputThread> input;
+    if (inputThread)
+        input.reset(new InputThread(world));
+    if (render) {
+        sista::clearScreen();
+        world.field->print(border);
+    }
+    report << "frame\tgames\tfps\tavg_us\tp99_us\tmax_us\tallocs/frame\tarena_B/frame\tpool_blocks\tentities\trss_KiB" << std::endl;
+    std::vector<std::chrono::nanoseconds> frameTimes;
+    frameTimes.reserve(interval);
+    unsigned long long games = 0;
+    unsigned long long allocations = 0; // Heap allocations made by the frames of the current interval
+    unsigned long long arenaBytes = 0; // Bytes taken from the frame arena by the frames of the current interval
+    unsigned i = 0; // Frame of the current game
+    auto start = std::chrono::steady_clock::now();
+    auto intervalStart = start;
+    for (unsigned long long frame=1; maxFrames == 0 || frame <= maxFrames; frame++) {
+        auto frameStart = std::chrono::steady_clock::now();
+        unsigned long long allocationsBefore = heapAllocations;
+        if (input)
+            input->apply(policy->decide(world));
+        else
+            applyAction(world, policy->decide(world));
+        world.update(i++, hardcore);
+        arenaBytes += world.arena.bytes();
+        if (memory)
+            for (MemoryRow& row : memoryRows)
+                row.peak = std::max(row.peak, world.entityCount(row.type));
+        if (render && i % 10 == 0) {
+            sista::clearScreen();
+            world.field->print(border);
+        }
+        if (world.end) { // Next game in the same world, so that leaks across games show up in the memory column
+            games++;
+            world.clear();
+            world.populate();
+            i = 0;
+        }
+        auto now = std::chrono::steady_clock::now();
+        allocations += heapAllocations - allocationsBefore;
+        frameTimes.push_back(now - frameStart);
+
+        if (frameTimes.size() == interval) {
+            std::sort(frameTimes.begin(), frameTimes.end());
+            std::chrono::nanoseconds total{0};
+            for (std::chrono::nanoseconds time : frameTimes)
+                total += time;
+            double seconds = std::chrono::duration<double>(now - intervalStart).count();
+            if (render)
+                cursor.goTo(HEIGHT + 3, 0);
+            report << frame << '\t' << games << '\t' << std::fixed << std::setprecision(0) << interval / seconds;
+            report << std::setprecision(1);
+            report << '\t' << total.count() / 1000.0 / interval;
+            report << '\t' << frameTimes[frameTimes.size() * 99 / 100].count() / 1000.0;
+            report << '\t' << frameTimes.back().count() / 1000.0;
+            report << std::setprecision(2) << '\t' << (double)allocations / interval;
+            report << std::setprecision(0) << '\t' << (double)arenaBytes / interval << '\t' << poolBlocks;
+            report << '\t' << world.entityCount() << '\t' << residentKiB() << std::endl;
+            frameTimes.clear();
+            allocations = 0;
+            arenaBytes = 0;
+            intervalStart = now;
+            if (maxSeconds != 0 && now - start >= std::chrono::seconds(maxSeconds))
+                break;
+        }
+    }
+    if (memory)
+        printMemory(report, memoryRows);
+    if (!render)
+        std::cout.rdbuf(report.rdbuf());
+    return 0;
+}
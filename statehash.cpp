@@ -0,0 +1,202 @@
+// State hashes of a headless game, one line per frame, to prove that two builds play exactly the same game
+//
+//  ./statehash [-p policy] [-f frames] [-s seed] [-c scenario] [-H] [-r inputs] [-i inputs] [-o hashes]
+//  ./statehash -d hashes hashes
+//
+// A bot plays from the seed, -r records its action of every frame to an input log, -i plays the actions of an input log
+// instead (with the seed and the mode it was recorded with), so that a change of the bot doesn't change the game.
+// Each line has the frame, GameWorld::stateHash, the hash of the field, the ammonitions of the player and the life of the
+// queen, after the update of that frame. -d compares two such files and reports the first frame where they differ.
+// The incremental hash of the field is checked against a full scan of the field after every frame.
+#include "bot.hpp"
+#include "scenario.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#define STATEHASH_FRAMES 20000 // Default number of frames, the game may end before
+#define INPUT_LOG_MAGIC "DINP"
+#define INPUT_LOG_VERSION 1
+
+// Followed by one BotAction per frame, written as it is
+struct InputLogHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t actionSize; // sizeof(BotAction)
+    uint32_t seed;
+    uint8_t hardcore;
+    uint8_t unused[3] = {};
+};
+static_assert(sizeof(BotAction) == 3, "BotAction is written to the input log as it is");
+
+struct HashRecord {
+    unsigned frame;
+    uint64_t state, field;
+    int ammonitions, life;
+};
+
+static bool parseRecord(const std::string& line, HashRecord& record) {
+    std::istringstream stream(line);
+    return (bool)(stream >> record.frame >> std::hex >> record.state >> record.field >> std::dec >> record.ammonitions >> record.life);
+}
+
+// Returns 0 if the files have the same frames, 1 at the first difference, 2 if one can't be read
+static int compare(const char* firstPath, const char* secondPath) {
+    std::ifstream first(firstPath), second(secondPath);
+    if (!first || !second) {
+        std::cerr << "Could not open " << (first ? secondPath : firstPath) << std::endl;
+        return 2;
+    }
+    std::string firstLine, secondLine;
+    std::getline(first, firstLine); // Headers
+    std::getline(second, secondLine);
+    unsigned compared = 0;
+    while (true) {
+        bool firstRead = (bool)std::getline(first, firstLine);
+        bool secondRead = (bool)std::getline(second, secondLine);
+        if (!firstRead || !secondRead) {
+            if (firstRead == secondRead) {
+                std::cout << "Identical, " << compared << " frames" << std::endl;
+                return 0;
+            }
+            std::cout << "Identical for " << compared << " frames, then " << (firstRead ? secondPath : firstPath) << " ends" << std::endl;
+            return 1;
+        }
+        HashRecord a, b;
+        if (!parseRecord(firstLine, a) || !parseRecord(secondLine, b)) {
+            std::cerr << "Invalid line " << compared + 2 << std::endl;
+            return 2;
+        }
+        if (a.frame != b.frame || a.state != b.state) {
+            std::cout << "First divergence at frame " << a.frame << ", after " << compared << " identical frames:";
+            if (a.field != b.field)
+                std::cout << " field";
+            if (a.ammonitions != b.ammonitions)
+                std::cout << " ammonitions";
+            if (a.life != b.life)
+                std::cout << " life";
+            if (a.frame != b.frame)
+                std::cout << " frame";
+            std::cout << std::endl << firstPath << '\t' << firstLine << std::endl << secondPath << '\t' << secondLine << std::endl;
+            return 1;
+        }
+        compared++;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string policyName = "heuristic";
+    unsigned frames = STATEHASH_FRAMES;
+    unsigned seed = 1;
+    bool hardcore = false;
+    std::string scenarioPath, recordPath, replayPath, outputPath;
+    for (int i=1; i<argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-d" && i + 2 < argc) {
+            return compare(argv[i + 1], argv[i + 2]);
+        } else if (arg == "-p" && i + 1 < argc) {
+            policyName = argv[++i];
+        } else if (arg == "-f" && i + 1 < argc) {
+            frames = std::atoi(argv[++i]);
+        } else if (arg == "-s" && i + 1 < argc) {
+            seed = std::atoi(argv[++i]);
+        } else if (arg == "-c" && i + 1 < argc) {
+            scenarioPath = argv[++i];
+        } else if (arg == "-r" && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (arg == "-i" && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (arg == "-o" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (arg == "-H") {
+            hardcore = true;
+        } else {
+            std::cerr << "Unknown argument " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    std::ifstream replay;
+    std::ofstream record;
+    if (!replayPath.empty()) {
+        replay.open(replayPath, std::ios::binary);
+        InputLogHeader header;
+        if (!replay || !replay.read((char*)&header, sizeof(header)) || std::memcmp(header.magic, INPUT_LOG_MAGIC, sizeof(header.magic)) != 0) {
+            std::cerr << replayPath << " is not an input log" << std::endl;
+            return 1;
+        }
+        if (header.version != INPUT_LOG_VERSION || header.actionSize != sizeof(BotAction)) {
+            std::cerr << replayPath << " has version " << header.version << " and " << header.actionSize << "B actions, expected ";
+            std::cerr << INPUT_LOG_VERSION << " and " << sizeof(BotAction) << "B" << std::endl;
+            return 1;
+        }
+        seed = header.seed;
+        hardcore = header.hardcore;
+    }
+    std::unique_ptr<Policy> policy = makePolicy(policyName, seed);
+    if (policy == nullptr) {
+        std::cerr << "Unknown policy " << policyName << std::endl;
+        return 1;
+    }
+    if (!recordPath.empty()) {
+        record.open(recordPath, std::ios::binary);
+        InputLogHeader header;
+        std::memcpy(header.magic, INPUT_LOG_MAGIC, sizeof(header.magic));
+        header.version = INPUT_LOG_VERSION;
+        header.actionSize = sizeof(BotAction);
+        header.seed = seed;
+        header.hardcore = hardcore;
+        if (!record.write((const char*)&header, sizeof(header))) {
+            std::cerr << "Could not create " << recordPath << std::endl;
+            return 1;
+        }
+    }
+    std::ofstream outputFile;
+    if (!outputPath.empty()) {
+        outputFile.open(outputPath);
+        if (!outputFile) {
+            std::cerr << "Could not create " << outputPath << std::endl;
+            return 1;
+        }
+    }
+    std::ostream output(outputPath.empty() ? std::cout.rdbuf() : outputFile.rdbuf());
+
+    NullBuffer nullBuffer;
+    std::cout.rdbuf(&nullBuffer); // Sista prints every change of the field on std::cout
+    GameWorld world(seed);
+    std::string error;
+    if (!scenarioPath.empty() && !loadScenario(world.scenario, scenarioPath, error)) {
+        std::cerr << "Invalid scenario, " << error << std::endl;
+        return 1;
+    }
+    world.populate();
+
+    output << "frame\tstate\tfield\tammo\tlife" << std::endl;
+    output << std::setfill('0');
+    for (unsigned i=0; i<frames && !world.end; i++) {
+        BotAction action;
+        if (replay.is_open()) {
+            if (!replay.read((char*)&action, sizeof(action)))
+                break; // The recorded game is over
+        } else {
+            action = policy->decide(world);
+        }
+        if (record.is_open())
+            record.write((const char*)&action, sizeof(action));
+        applyAction(world, action);
+        world.update(i, hardcore);
+
+        if (world.field->hash != world.field->recompute()) { // A change of the field went around HashedField
+            std::cerr << "Frame " << i << ": the incremental hash of the field differs from the field" << std::endl;
+            return 1;
+        }
+        output << std::dec << i << '\t' << std::hex << std::setw(16) << world.stateHash() << '\t' << std::setw(16) << world.field->hash;
+        output << '\t' << std::dec << world.player->ammonitions << '\t' << world.queen->life << '\n';
+    }
+    output.flush();
+    return 0;
+}
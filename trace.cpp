@@ -0,0 +1,107 @@
+#include "trace.hpp"
+#include <chrono>
+#include <cstring>
+
+Tracer tracer;
+thread_local uint32_t traceFrame = 0;
+
+const char* traceKindNames[TRACE_KINDS] = {
+    "game_started", "game_over", "snapshot_saved", "snapshot_loaded", "snapshot_invalid", "music_unavailable",
+    "integrity_mismatch", "bullet_removed", "nullptrs_removed", "events_dropped"
+};
+const char* traceLevelNames[TRACE_DEBUG + 1] = {"off", "error", "info", "debug"};
+
+bool parseTraceLevel(const std::string& name, TraceLevel& level) {
+    for (unsigned j=TRACE_ERROR; j<=TRACE_DEBUG; j++) {
+        if (name == traceLevelNames[j]) {
+            level = (TraceLevel)j;
+            return true;
+        }
+    }
+    return false;
+}
+
+Tracer::Tracer() {
+    for (unsigned long long j=0; j<TRACE_RING; j++)
+        ring[j].sequence.store(j, std::memory_order_relaxed);
+}
+
+Tracer::~Tracer() {
+    stop();
+}
+
+void Tracer::push(const TraceEvent& event) {
+    unsigned long long position = head.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+        cell = &ring[position % TRACE_RING];
+        long long lag = (long long)(cell->sequence.load(std::memory_order_acquire) - position);
+        if (lag == 0) {
+            if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        } else if (lag < 0) {
+            dropped.fetch_add(1, std::memory_order_relaxed); // The flush thread is late, losing an event is better than waiting
+            return;
+        } else {
+            position = head.load(std::memory_order_relaxed); // Another thread claimed the cell first
+        }
+    }
+    cell->event = event;
+    cell->sequence.store(position + 1, std::memory_order_release);
+}
+
+bool Tracer::start(const std::string& path, TraceLevel level) {
+    file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+    TraceHeader header;
+    std::memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.eventSize = sizeof(TraceEvent);
+    std::fwrite(&header, sizeof(header), 1, file);
+    running = true;
+    thread = std::thread(&Tracer::run, this);
+    this->level = level;
+    return true;
+}
+
+void Tracer::stop() {
+    if (!running)
+        return;
+    level = TRACE_OFF;
+    running = false;
+    thread.join();
+    std::fclose(file);
+    file = nullptr;
+}
+
+void Tracer::run() {
+    while (running) {
+        if (!flush())
+            std::this_thread::sleep_for(std::chrono::milliseconds(TRACE_FLUSH_PERIOD));
+    }
+    flush(); // What was traced while the thread was stopping
+}
+
+bool Tracer::flush() {
+    TraceEvent batch[257]; // The events of the ring, plus one EVENTS_DROPPED
+    std::size_t count = 0;
+    while (count < 256) {
+        Cell& cell = ring[tail % TRACE_RING];
+        if (cell.sequence.load(std::memory_order_acquire) != tail + 1)
+            break; // Empty, or the producer that claimed the cell is still writing it
+        batch[count++] = cell.event;
+        cell.sequence.store(tail + TRACE_RING, std::memory_order_release);
+        tail++;
+    }
+    unsigned long long lost = dropped.exchange(0, std::memory_order_relaxed);
+    if (lost > 0) {
+        TraceEvent event = {count > 0 ? batch[count - 1].frame : 0, EVENTS_DROPPED, TRACE_ERROR, TRACE_NO_TYPE, 0, 0, 0, (uint32_t)lost};
+        batch[count++] = event;
+    }
+    if (count == 0)
+        return false;
+    std::fwrite(batch, sizeof(TraceEvent), count, file);
+    std::fflush(file);
+    return true;
+}
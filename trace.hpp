@@ -0,0 +1,103 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#define TRACE_FILE "dodas.trace" // Default path of the trace, decoded by tracedump
+#define TRACE_MAGIC "DTRC"
+#define TRACE_VERSION 1
+#define TRACE_RING 4096 // Events buffered between the threads that trace and the flush thread, a power of two
+#define TRACE_FLUSH_PERIOD 50 // Milliseconds between two flushes of the ring to the file
+#define TRACE_NO_TYPE 0xFF // Type of the events that aren't about an entity
+
+// An event is traced if its level is lower than or equal to the level of the tracer
+enum TraceLevel : uint8_t {TRACE_OFF, TRACE_ERROR, TRACE_INFO, TRACE_DEBUG};
+
+enum TraceKind : uint8_t {
+    GAME_STARTED, // value: 1 if hardcore + 2 if endless
+    GAME_OVER, // value: life left to the queen
+    SNAPSHOT_SAVED, // value: bytes
+    SNAPSHOT_LOADED, // value: bytes
+    SNAPSHOT_INVALID, // value: size of the file
+    MUSIC_UNAVAILABLE, // value: the player that failed, 0 afplay, 1 ffplay, 2 aplay
+    INTEGRITY_MISMATCH, // type and coordinates of the entity, value: IntegrityMismatch::Kind
+    BULLET_REMOVED, // value: bullets left in the list
+    NULLPTRS_REMOVED, // value: null entries erased from a list
+    EVENTS_DROPPED, // Written by the flush thread, value: events lost since the previous one because the ring was full
+    TRACE_KINDS
+};
+extern const char* traceKindNames[TRACE_KINDS];
+extern const char* traceLevelNames[TRACE_DEBUG + 1];
+
+// Fixed-size record, written to the file as it is (native byte order) after the header
+struct TraceEvent {
+    uint32_t frame;
+    TraceKind kind;
+    TraceLevel level;
+    uint8_t type; // Type of the entity, TRACE_NO_TYPE if none
+    uint8_t unused = 0;
+    int16_t y, x;
+    uint32_t value;
+};
+static_assert(sizeof(TraceEvent) == 16, "TraceEvent is written to the trace file as it is");
+
+struct TraceHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t eventSize; // sizeof(TraceEvent), to detect a decoder built for another layout
+};
+
+// Binary trace of the game: tracing copies a TraceEvent into a lock-free ring (any thread can trace),
+// a background thread writes the ring to the file every TRACE_FLUSH_PERIOD milliseconds.
+// When the ring is full the event is dropped and counted, tracing never blocks nor allocates.
+class Tracer {
+public:
+    std::atomic<uint8_t> level{TRACE_OFF}; // Can be changed while running
+
+    Tracer();
+    ~Tracer();
+
+    bool start(const std::string& path, TraceLevel); // Opens the file and starts the flush thread, false if the file can't be created
+    void stop(); // Flushes what's left in the ring, joins the thread and closes the file
+    void push(const TraceEvent&);
+
+private:
+    // Bounded multi-producer single-consumer queue: a cell is free for the producer that claimed position p
+    // when its sequence is p, and readable by the flush thread when its sequence is p + 1
+    struct Cell {
+        std::atomic<unsigned long long> sequence;
+        TraceEvent event;
+    };
+    Cell ring[TRACE_RING];
+    std::atomic<unsigned long long> head{0}; // Next position to claim
+    unsigned long long tail = 0; // Next position to read, owned by the flush thread
+    std::atomic<unsigned long long> dropped{0};
+
+    std::FILE* file = nullptr;
+    std::atomic<bool> running{false};
+    std::thread thread;
+
+    void run();
+    bool flush(); // Writes every readable event, returns false if there was none
+};
+
+extern Tracer tracer;
+extern thread_local uint32_t traceFrame; // Frame of the events traced by this thread, set by GameWorld::update
+
+inline void trace(TraceLevel level, TraceKind kind, uint8_t type, int16_t y, int16_t x, uint32_t value = 0) {
+    if (level > tracer.level.load(std::memory_order_relaxed))
+        return;
+    TraceEvent event;
+    event.frame = traceFrame;
+    event.kind = kind;
+    event.level = level;
+    event.type = type;
+    event.y = y;
+    event.x = x;
+    event.value = value;
+    tracer.push(event);
+}
+
+bool parseTraceLevel(const std::string&, TraceLevel&); // "error", "info" or "debug"
@@ -0,0 +1,79 @@
+// Decoder of the binary traces written by --trace: prints one event per line, or how many events of each kind there are
+//
+//  ./tracedump [-l level] [-c] [trace file]
+//
+// -l keeps the events up to the given level (error, info or debug), -c counts the events of each kind instead of listing them.
+// Without a file TRACE_FILE is decoded.
+#include "dodas.hpp"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv) {
+    std::string path = TRACE_FILE;
+    TraceLevel level = TRACE_DEBUG;
+    bool count = false;
+    for (int i=1; i<argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-l" && i + 1 < argc) {
+            if (!parseTraceLevel(argv[++i], level)) {
+                std::cerr << "Unknown trace level " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "-c") {
+            count = true;
+        } else if (arg[0] != '-') {
+            path = arg;
+        } else {
+            std::cerr << "Unknown argument " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Could not open " << path << std::endl;
+        return 1;
+    }
+    TraceHeader header;
+    if (!file.read((char*)&header, sizeof(header)) || std::memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0) {
+        std::cerr << path << " is not a Dodas trace" << std::endl;
+        return 1;
+    }
+    if (header.version != TRACE_VERSION || header.eventSize != sizeof(TraceEvent)) {
+        std::cerr << path << " has version " << header.version << " and " << header.eventSize << "B events, expected ";
+        std::cerr << TRACE_VERSION << " and " << sizeof(TraceEvent) << "B" << std::endl;
+        return 1;
+    }
+
+    unsigned long long counts[TRACE_KINDS] = {};
+    TraceEvent event;
+    if (!count)
+        std::cout << "frame\tlevel\tkind\ttype\ty\tx\tvalue" << std::endl;
+    while (file.read((char*)&event, sizeof(event))) {
+        if (event.level > level)
+            continue;
+        if (event.kind >= TRACE_KINDS || event.level == TRACE_OFF || event.level > TRACE_DEBUG) {
+            std::cerr << "Corrupted event at offset " << (unsigned long long)file.tellg() - sizeof(event) << std::endl;
+            return 1;
+        }
+        if (count) {
+            counts[event.kind]++;
+            continue;
+        }
+        std::cout << event.frame << '\t' << traceLevelNames[event.level] << '\t' << traceKindNames[event.kind] << '\t';
+        std::cout << (event.type <= Type::QUEEN ? typeNames[event.type] : "-") << '\t';
+        std::cout << event.y << '\t' << event.x << '\t' << event.value << '\n';
+    }
+    if (file.gcount() != 0)
+        std::cerr << "Truncated event at the end of " << path << std::endl; // The game was killed during a flush
+    if (count) {
+        std::cout << "kind\tevents" << std::endl;
+        for (unsigned j=0; j<TRACE_KINDS; j++) {
+            if (counts[j] > 0)
+                std::cout << traceKindNames[j] << '\t' << counts[j] << std::endl;
+        }
+    }
+    return 0;
+}